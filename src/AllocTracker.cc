@@ -0,0 +1,127 @@
+//
+// AllocTracker.cc
+// Implementation of optional allocation accounting
+//
+
+#include "AllocTracker.h"
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <new>
+
+void AllocStats::reset()
+{
+    std::fill(allocs, allocs + NUM_ALLOC_CATEGORIES, 0);
+    std::fill(frees, frees + NUM_ALLOC_CATEGORIES, 0);
+    std::fill(bytes, bytes + NUM_ALLOC_CATEGORIES, 0);
+    std::fill(liveBytes, liveBytes + NUM_ALLOC_CATEGORIES, 0);
+    std::fill(peakLiveBytesPerCategory, peakLiveBytesPerCategory + NUM_ALLOC_CATEGORIES, 0);
+    totalLiveBytes = 0;
+    peakLiveBytes = 0;
+}
+
+const char *allocCategoryName(int category)
+{
+    switch (category) {
+        case ALLOC_PACKET:        return "packet";
+        case ALLOC_VISITED_NODES: return "visitedNodes";
+        case ALLOC_ROUTE_PATH:    return "routePath";
+        case ALLOC_ROUTE_LIST:    return "routeList";
+        case ALLOC_ROUTE_TABLE:   return "routeTable";
+        default:                  return "unknown";
+    }
+}
+
+#ifdef BAT_ALLOC_TRACKING
+
+namespace alloctracker {
+
+namespace {
+
+// Prepended to every tracked block; padded to keep the payload max-aligned
+struct alignas(std::max_align_t) BlockHeader {
+    AllocStats *owner;
+    size_t size;
+    int category;
+};
+
+thread_local AllocStats *currentStats = nullptr;
+
+std::deque<AllocStats>& registry()
+{
+    // Intentionally leaked: blocks freed during static destruction may still
+    // reference their owner's entry. A deque keeps element addresses stable.
+    static std::deque<AllocStats> *stats = new std::deque<AllocStats>();
+    return *stats;
+}
+
+AllocStats *unowned = nullptr;
+
+} // namespace
+
+AllocStats *registerOwner()
+{
+    registry().emplace_back();
+    return &registry().back();
+}
+
+AllocStats *unownedStats()
+{
+    return unowned ? unowned : startUnownedRun();
+}
+
+AllocStats *startUnownedRun()
+{
+    unowned = registerOwner();
+    return unowned;
+}
+
+AllocStats *currentOwner()
+{
+    return currentStats;
+}
+
+void setCurrentOwner(AllocStats *stats)
+{
+    currentStats = stats;
+}
+
+void *allocate(size_t bytes, int category)
+{
+    void *raw = std::malloc(sizeof(BlockHeader) + bytes);
+    if (!raw)
+        throw std::bad_alloc();
+
+    AllocStats *owner = currentStats ? currentStats : unownedStats();
+    BlockHeader *header = static_cast<BlockHeader*>(raw);
+    header->owner = owner;
+    header->size = bytes;
+    header->category = category;
+
+    owner->allocs[category]++;
+    owner->bytes[category] += bytes;
+    owner->liveBytes[category] += bytes;
+    owner->peakLiveBytesPerCategory[category] =
+        std::max(owner->peakLiveBytesPerCategory[category], owner->liveBytes[category]);
+    owner->totalLiveBytes += bytes;
+    owner->peakLiveBytes = std::max(owner->peakLiveBytes, owner->totalLiveBytes);
+
+    return header + 1;
+}
+
+void deallocate(void *p) noexcept
+{
+    if (!p) return;
+
+    BlockHeader *header = static_cast<BlockHeader*>(p) - 1;
+    AllocStats *owner = header->owner;
+    owner->frees[header->category]++;
+    owner->liveBytes[header->category] -= header->size;
+    owner->totalLiveBytes -= header->size;
+
+    std::free(header);
+}
+
+} // namespace alloctracker
+
+#endif
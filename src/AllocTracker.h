@@ -0,0 +1,132 @@
+//
+// AllocTracker.h
+// Optional per-class allocation accounting for BatRouting
+//
+// Compiled in only when BAT_ALLOC_TRACKING is defined (make ALLOC_TRACKING=1).
+// Without it, TrackedAllocator is plain std::allocator and BAT_ALLOC_SCOPE
+// expands to nothing, so the normal build is unchanged.
+//
+// Every tracked allocation carries a small header recording the owner's
+// AllocStats and the category, so frees are always charged back to the
+// module that allocated, regardless of which module releases the memory
+// (e.g. a RouteDiscoveryPacket dup()ed by the sender and deleted by the
+// receiver stays on the sender's books until it is freed).
+//
+
+#ifndef __BAT_ALGORITHM_ALLOCTRACKER_H_
+#define __BAT_ALGORITHM_ALLOCTRACKER_H_
+
+#include <cstddef>
+#include <memory>
+
+// What the memory is used for
+enum AllocCategory {
+    ALLOC_PACKET,          // RouteDiscoveryPacket / DataPacket objects
+    ALLOC_VISITED_NODES,   // RouteDiscoveryPacket::visitedNodes storage
+    ALLOC_ROUTE_PATH,      // RouteInfo::path and DataPacket::routePath storage
+    ALLOC_ROUTE_LIST,      // Per-destination std::vector<RouteInfo> storage
+    ALLOC_ROUTE_TABLE,     // routeTable map nodes
+    NUM_ALLOC_CATEGORIES
+};
+
+// Counters of one owner (one BatRouting instance)
+struct AllocStats {
+    long allocs[NUM_ALLOC_CATEGORIES];
+    long frees[NUM_ALLOC_CATEGORIES];
+    long bytes[NUM_ALLOC_CATEGORIES];           // Total bytes ever allocated
+    long liveBytes[NUM_ALLOC_CATEGORIES];
+    long peakLiveBytesPerCategory[NUM_ALLOC_CATEGORIES];
+    long totalLiveBytes;
+    long peakLiveBytes;
+
+    AllocStats() { reset(); }
+    void reset();
+};
+
+const char *allocCategoryName(int category);
+
+#ifdef BAT_ALLOC_TRACKING
+
+namespace alloctracker {
+
+// Fresh counters for a new owner (one per module instance and run).
+// Entries are never destroyed or reused, so blocks that outlive their
+// owner (e.g. into the next run) keep charging the old entry and never
+// drive a successor's live counters negative.
+AllocStats *registerOwner();
+
+// Counters charged outside any AllocScope. startUnownedRun() switches to a
+// fresh entry, for the same reason as registerOwner().
+AllocStats *unownedStats();
+AllocStats *startUnownedRun();
+
+// Owner charged by allocations on the calling thread (unowned if none)
+AllocStats *currentOwner();
+void setCurrentOwner(AllocStats *stats);
+
+void *allocate(size_t bytes, int category);
+void deallocate(void *p) noexcept;
+
+} // namespace alloctracker
+
+// RAII guard selecting the owner charged by allocations in its scope
+class AllocScope
+{
+  private:
+    AllocStats *previous;
+
+  public:
+    explicit AllocScope(AllocStats *stats) : previous(alloctracker::currentOwner()) {
+        alloctracker::setCurrentOwner(stats);
+    }
+    ~AllocScope() { alloctracker::setCurrentOwner(previous); }
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+};
+
+// Stateless allocator charging a fixed category to the current owner
+template <class T, int Category>
+struct TrackingAllocator {
+    typedef T value_type;
+
+    template <class U>
+    struct rebind { typedef TrackingAllocator<U, Category> other; };
+
+    TrackingAllocator() noexcept {}
+    template <class U>
+    TrackingAllocator(const TrackingAllocator<U, Category>&) noexcept {}
+
+    T *allocate(size_t n) {
+        return static_cast<T*>(alloctracker::allocate(n * sizeof(T), Category));
+    }
+    void deallocate(T *p, size_t) noexcept {
+        alloctracker::deallocate(p);
+    }
+
+    template <class U>
+    bool operator==(const TrackingAllocator<U, Category>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const TrackingAllocator<U, Category>&) const noexcept { return false; }
+};
+
+template <class T, int Category>
+using TrackedAllocator = TrackingAllocator<T, Category>;
+
+#define BAT_ALLOC_SCOPE(stats) AllocScope batAllocScope_(stats)
+
+// Class-specific operator new/delete for tracked message classes
+#define BAT_TRACKED_NEW(category) \
+    static void *operator new(size_t size) { return alloctracker::allocate(size, category); } \
+    static void operator delete(void *p) noexcept { alloctracker::deallocate(p); }
+
+#else
+
+template <class T, int Category>
+using TrackedAllocator = std::allocator<T>;
+
+#define BAT_ALLOC_SCOPE(stats)
+#define BAT_TRACKED_NEW(category)
+
+#endif
+
+#endif
@@ -6,8 +6,11 @@
  */
 
 #include "ArbitraryMobility.h"
+#include "ObstacleField.h"
 #include "inet/common/ModuleAccess.h"
 #include <cmath>
+#include <cstring>
+#include <limits>
 
 using namespace omnetpp;
 using namespace inet;
@@ -18,6 +21,9 @@ ArbitraryMobility::ArbitraryMobility()
 {
     lastUpdate = 0;
     moveTimer = nullptr;
+    obstacles = nullptr;
+    fingerprintPositions = false;
+    peekTime = -1;
 }
 
 ArbitraryMobility::~ArbitraryMobility()
@@ -37,6 +43,13 @@ void ArbitraryMobility::initialize(int stage)
         constraintAreaMaxY = par("constraintAreaMaxY");
         minAltitude = par("constraintAreaMinZ");
         maxAltitude = par("constraintAreaMaxZ");
+        fingerprintPositions = par("fingerprintPositions");
+        
+        if (strlen(par("obstacleFieldModule").stringValue()) > 0)
+            obstacles = getModuleFromPar<ObstacleField>(par("obstacleFieldModule"), this);
+        
+        if (strlen(par("traceFile").stringValue()) > 0)
+            initializeTrace();
         
         // Create movement timer
         moveTimer = new cMessage("moveTimer");
@@ -45,16 +58,78 @@ void ArbitraryMobility::initialize(int stage)
            << "] Y[" << constraintAreaMinY << "," << constraintAreaMaxY 
            << "] Z[" << minAltitude << "," << maxAltitude << "]" << endl;
     }
-    else if (stage == INITSTAGE_LAST) {
-        // Start periodic movement updates
+    else if (stage == INITSTAGE_LAST && !trace) {
+        // Start periodic movement updates (trace replay moves on demand)
         double updateInterval = par("updateInterval");
         scheduleAt(simTime() + updateInterval, moveTimer);
         EV << "ArbitraryMobility: Movement timer scheduled with interval " << updateInterval << "s" << endl;
     }
 }
 
+void ArbitraryMobility::initializeTrace()
+{
+    trace = MobilityTrace::open(par("traceFile").stdstringValue());
+    
+    int traceId = par("traceId");
+    if (traceId < 0)
+        traceId = getParentModule()->getIndex();
+    if (traceId >= trace->getNumTracks())
+        throw cRuntimeError("ArbitraryMobility: traceId %d out of range, '%s' has %d tracks",
+                            traceId, par("traceFile").stringValue(), trace->getNumTracks());
+    traceCursor.attach(*trace, traceId);
+    
+    EV << "ArbitraryMobility: Replaying track " << traceId << " of " << par("traceFile").stringValue() << endl;
+}
+
+void ArbitraryMobility::replayTrace()
+{
+    traceCursor.getState(simTime().dbl(), lastPosition, lastVelocity);
+    
+    if (fingerprintPositions) {
+        FINGERPRINT_ADD_EXTRA_DATA(getParentModule()->getIndex());
+        FINGERPRINT_ADD_EXTRA_DATA(lastPosition.x);
+        FINGERPRINT_ADD_EXTRA_DATA(lastPosition.y);
+        FINGERPRINT_ADD_EXTRA_DATA(lastPosition.z);
+    }
+}
+
+void ArbitraryMobility::peekTrace() const
+{
+    // Leaves the model state (and the fingerprint) alone
+    simtime_t now = simTime();
+    if (now != peekTime) {
+        traceCursor.getState(now.dbl(), peekPosition, peekVelocity);
+        peekTime = now;
+    }
+}
+
+const Coord& ArbitraryMobility::getLastPosition() const
+{
+    if (trace) {
+        peekTrace();
+        return peekPosition;
+    }
+    return lastPosition;
+}
+
+const Coord& ArbitraryMobility::getLastVelocity() const
+{
+    if (trace) {
+        peekTrace();
+        return peekVelocity;
+    }
+    return lastVelocity;
+}
+
 void ArbitraryMobility::setInitialPosition()
 {
+    // Trace replay draws no random numbers
+    if (trace) {
+        replayTrace();
+        lastUpdate = simTime();
+        return;
+    }
+    
     // Read initial position from parameters
     double x = par("initialX");
     double y = par("initialY");
@@ -67,6 +142,20 @@ void ArbitraryMobility::setInitialPosition()
     
     lastPosition = Coord(x, y, z);
     
+    // A start inside an obstacle is redrawn over the constraint area. The
+    // extra draws only happen then, so other runs keep their random streams.
+    ObstacleBox box;
+    const int maxPlacementAttempts = 100;
+    for (int attempt = 0; obstacles && obstacles->findContainingObstacle(lastPosition, box); attempt++) {
+        if (attempt == maxPlacementAttempts)
+            throw cRuntimeError("ArbitraryMobility: Initial position (%g, %g, %g) is inside an obstacle and %d "
+                                "redraws found no free position", x, y, z, maxPlacementAttempts);
+        x = uniform(constraintAreaMinX, constraintAreaMaxX, 0);
+        y = uniform(constraintAreaMinY, constraintAreaMaxY, 0);
+        z = uniform(minAltitude, maxAltitude, 0);
+        lastPosition = Coord(x, y, z);
+    }
+    
     // Set initial velocity with random direction
     double speed = uniform(par("minSpeed").doubleValue(), par("maxSpeed").doubleValue());
     double angleXY = uniform(0, 2 * M_PI, 0);
@@ -82,6 +171,12 @@ void ArbitraryMobility::setInitialPosition()
 void ArbitraryMobility::move()
 {
     simtime_t now = simTime();
+    
+    if (trace) {
+        replayTrace();
+        lastUpdate = now;
+        return;
+    }
     double elapsedTime = (now - lastUpdate).dbl();
     
     if (elapsedTime > 0) {
@@ -124,6 +219,31 @@ void ArbitraryMobility::move()
             bounced = true;
         }
         
+        // Reflect off obstacle faces: stop just short of the first hit and
+        // mirror the velocity about the face normal
+        double hitT;
+        Coord normal;
+        ObstacleBox inside;
+        if (obstacles && obstacles->findFirstHit(lastPosition, newPosition, hitT, normal)) {
+            // A hit at t=0 may mean the UAV is already inside (moved there by
+            // setPositionVelocity()): reflecting in place would leave it stuck
+            if (hitT <= 0 && obstacles->findContainingObstacle(lastPosition, inside)) {
+                escapeObstacle(inside);
+                newPosition = lastPosition;
+            }
+            else {
+                Coord step = newPosition - lastPosition;
+                double stepLength = step.length();
+                double backoff = stepLength > 0 ? 0.01 / stepLength : 0;
+                newPosition = lastPosition + step * std::max(0.0, hitT - backoff);
+            
+                double vn = lastVelocity.x * normal.x + lastVelocity.y * normal.y + lastVelocity.z * normal.z;
+                if (vn < 0)
+                    lastVelocity = lastVelocity - normal * (2 * vn);
+            }
+            bounced = true;
+        }
+        
         lastPosition = newPosition;
         
         // Occasionally change direction randomly (every ~5-10 seconds on average)
@@ -143,12 +263,55 @@ void ArbitraryMobility::move()
             EV << "ArbitraryMobility: Random direction change at t=" << now << endl;
         }
         
+        if (fingerprintPositions) {
+            FINGERPRINT_ADD_EXTRA_DATA(getParentModule()->getIndex());
+            FINGERPRINT_ADD_EXTRA_DATA(lastPosition.x);
+            FINGERPRINT_ADD_EXTRA_DATA(lastPosition.y);
+            FINGERPRINT_ADD_EXTRA_DATA(lastPosition.z);
+        }
+        
         emitMobilityStateChangedSignal();
     }
     
     lastUpdate = now;
 }
 
+void ArbitraryMobility::escapeObstacle(const ObstacleBox &box)
+{
+    // Leave through the nearest face that is inside the constraint area
+    // (buildings stand on the ground, so usually not the bottom one) and
+    // point the velocity outwards on that axis
+    const double margin = 0.01;
+    double lo[3] = {box.min.x, box.min.y, box.min.z};
+    double hi[3] = {box.max.x, box.max.y, box.max.z};
+    double pos[3] = {lastPosition.x, lastPosition.y, lastPosition.z};
+    double areaMin[3] = {constraintAreaMinX, constraintAreaMinY, minAltitude};
+    double areaMax[3] = {constraintAreaMaxX, constraintAreaMaxY, maxAltitude};
+    
+    int bestAxis = 2;
+    double bestTarget = hi[2] + margin;
+    double bestDistance = std::numeric_limits<double>::infinity();
+    for (int axis = 0; axis < 3; axis++) {
+        double targets[2] = {lo[axis] - margin, hi[axis] + margin};
+        for (double target : targets) {
+            double distance = std::fabs(target - pos[axis]);
+            if (target >= areaMin[axis] && target <= areaMax[axis] && distance < bestDistance) {
+                bestAxis = axis;
+                bestTarget = target;
+                bestDistance = distance;
+            }
+        }
+    }
+    
+    double *velocity[3] = {&lastVelocity.x, &lastVelocity.y, &lastVelocity.z};
+    double speed = std::fabs(*velocity[bestAxis]);
+    *velocity[bestAxis] = bestTarget > pos[bestAxis] ? speed : -speed;
+    pos[bestAxis] = bestTarget;
+    lastPosition = Coord(pos[0], pos[1], pos[2]);
+    
+    EV_WARN << "ArbitraryMobility: Was inside an obstacle, moved out to " << lastPosition << endl;
+}
+
 void ArbitraryMobility::orient()
 {
     // Orientation not needed for this simulation
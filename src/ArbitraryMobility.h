@@ -8,10 +8,14 @@
 #define ARBITRARYMOBILITY_H_
 
 #include "inet/mobility/base/MovingMobilityBase.h"
+#include "MobilityTrace.h"
 
 using namespace omnetpp;
 using namespace inet;
 
+class ObstacleField;
+struct ObstacleBox;
+
 class INET_API ArbitraryMobility : public MovingMobilityBase {
 private:
     // State variables
@@ -25,9 +29,25 @@ private:
     double minAltitude;
     double maxAltitude;
 
+    // Optional obstacles to bounce off (nullptr if none)
+    ObstacleField *obstacles;
+
     // Timer for periodic updates
     cMessage *moveTimer;
 
+    // Feed positions into the event fingerprint (regression tests)
+    bool fingerprintPositions;
+
+    // Trace replay (traceFile set): positions come from the mapped trace
+    // instead of the random walk; nullptr in random mode
+    std::shared_ptr<const MobilityTrace> trace;
+    mutable TraceCursor traceCursor;
+
+    // Trace state at peekTime for getLastPosition()/getLastVelocity()
+    mutable simtime_t peekTime;
+    mutable Coord peekPosition;
+    mutable Coord peekVelocity;
+
 protected:
     virtual void initialize(int stage) override;
     virtual void setInitialPosition() override;
@@ -36,6 +56,11 @@ protected:
     virtual void finish() override;
     virtual void handleSelfMessage(cMessage *message) override;
 
+    void initializeTrace();
+    void replayTrace();
+    void escapeObstacle(const ObstacleBox &box);
+    void peekTrace() const;
+
 public:
     ArbitraryMobility();
     virtual ~ArbitraryMobility();
@@ -43,6 +68,16 @@ public:
     // External interface for position/velocity updates
     virtual void setPositionVelocity(const Coord& position, const Coord& velocity);
     virtual double getMaxSpeed() const override;
+
+    // Last computed state, without advancing the model. This is the access
+    // for observers (SwarmTelemetry, RouteOracle): getCurrentPosition()
+    // calls move(), which draws random numbers for direction changes, so
+    // reading through it would make the trajectory depend on when and how
+    // often someone looks. In trace replay they are interpolated to simTime() instead (replay
+    // draws no random numbers either), so they are current even with
+    // updateInterval = 0s.
+    const Coord& getLastPosition() const;
+    const Coord& getLastVelocity() const;
 };
 
 #endif /* ARBITRARYMOBILITY_H_ */
@@ -6,18 +6,37 @@
 #include "BatRouting.h"
 #include "inet/common/ModuleAccess.h"
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 Define_Module(BatRouting);
 
 BatRouting::BatRouting()
 {
     routeUpdateTimer = nullptr;
+    dataTimer = nullptr;
+    obstacles = nullptr;
+    geographicRouting = false;
     myNodeId = -1;
+    numRouteRequestsSent = 0;
+    numRoutesDiscovered = 0;
+    numPacketsRouted = 0;
+    numDataSent = 0;
+    numDataForwarded = 0;
+    numDataDelivered = 0;
+    numDataDropped = 0;
+    measureWallTime = false;
+    routingWallTime = 0;
+    wallTimeDepth = 0;
+#ifdef BAT_ALLOC_TRACKING
+    allocStats = nullptr;
+#endif
 }
 
 BatRouting::~BatRouting()
 {
     cancelAndDelete(routeUpdateTimer);
+    cancelAndDelete(dataTimer);
 }
 
 void BatRouting::initialize()
@@ -30,6 +49,12 @@ void BatRouting::initialize()
     }
     myNodeId = parent->getIndex();
     
+#ifdef BAT_ALLOC_TRACKING
+    allocStats = alloctracker::registerOwner();
+    if (myNodeId == 0)
+        alloctracker::startUnownedRun();
+#endif
+    
     // Initialize Bat Algorithm parameters
     frequencyMin = par("frequencyMin");
     frequencyMax = par("frequencyMax");
@@ -48,29 +73,64 @@ void BatRouting::initialize()
     mobilityWeight = par("mobilityWeight");
     maxRoutesPerDestination = par("maxRoutesPerDestination");
     routeTimeout = par("routeTimeout");
+    fingerprintRouting = par("fingerprintRouting");
+    measureWallTime = par("measureWallTime");
+    synchronizedEpochs = par("synchronizedEpochs");
+    commRange = par("commRange");
+    maxDataHops = par("maxDataHops");
+    dataInterval = par("dataInterval");
+    
+    const char *routingMode = par("routingMode").stringValue();
+    if (strcmp(routingMode, "geographic") == 0)
+        geographicRouting = true;
+    else if (strcmp(routingMode, "table") != 0)
+        throw cRuntimeError("BatRouting: Unknown routingMode '%s' (expected \"table\" or \"geographic\")", routingMode);
+    
+    // Optional obstacle model for line-of-sight checks
+    if (strlen(par("obstacleFieldModule").stringValue()) > 0)
+        obstacles = getModuleFromPar<ObstacleField>(par("obstacleFieldModule"), this);
     
     // Register signals
     routeDiscoveredSignal = registerSignal("routeDiscovered");
     packetRoutedSignal = registerSignal("packetRouted");
+    dataDeliveredSignal = registerSignal("dataDelivered");
+    dataDroppedSignal = registerSignal("dataDropped");
+    
+    // Schedule first route discovery (delayed to allow other modules to initialize).
+    // With synchronized epochs, RoutingEpochCoordinator drives the updates instead.
+    if (!synchronizedEpochs) {
+        routeUpdateTimer = new cMessage("routeUpdate");
+        scheduleAt(simTime() + uniform(2, 3), routeUpdateTimer);
+    }
     
-    // Schedule first route discovery (delayed to allow other modules to initialize)
-    routeUpdateTimer = new cMessage("routeUpdate");
-    scheduleAt(simTime() + uniform(2, 3), routeUpdateTimer);
+    // Optional data traffic to random destinations
+    if (dataInterval > 0) {
+        dataTimer = new cMessage("dataTimer");
+        scheduleAt(simTime() + par("dataStartTime").doubleValue() + uniform(0, dataInterval), dataTimer);
+    }
     
     EV << "BatRouting: Node " << myNodeId << " initialized" << endl;
 }
 
 void BatRouting::handleMessage(cMessage *msg)
 {
+    // Charge everything allocated while handling this event to this node
+    BAT_ALLOC_SCOPE(allocStats);
+    startWallTime();
+    
     if (msg == routeUpdateTimer) {
         // Periodic route discovery and optimization
         discoverRoutes();
-        optimizeRouteTable();
-        cleanupExpiredRoutes();
+        maintainRouteTable(simTime());
+        recordRouteUpdate();
         
         // Schedule next update
         scheduleAt(simTime() + routingUpdateInterval, routeUpdateTimer);
     }
+    else if (msg == dataTimer) {
+        sendDataPacket();
+        scheduleAt(simTime() + dataInterval, dataTimer);
+    }
     else if (auto routePkt = dynamic_cast<RouteDiscoveryPacket*>(msg)) {
         // Process route discovery packet
         processRouteDiscovery(routePkt);
@@ -83,10 +143,31 @@ void BatRouting::handleMessage(cMessage *msg)
         // Unknown message
         delete msg;
     }
+    
+    stopWallTime();
+}
+
+void BatRouting::startWallTime()
+{
+    // Only the outermost call measures: maintainRouteTable() is timed on its
+    // own when the epoch coordinator calls it, and inside handleMessage()
+    // otherwise
+    if (measureWallTime && wallTimeDepth++ == 0)
+        wallTimeStart = std::chrono::steady_clock::now();
+}
+
+void BatRouting::stopWallTime()
+{
+    if (measureWallTime && --wallTimeDepth == 0)
+        routingWallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallTimeStart).count();
 }
 
 void BatRouting::discoverRoutes()
 {
+    // Geographic forwarding needs no periodic discovery; it only requests
+    // routes on demand when a packet gets stuck at a local minimum
+    if (geographicRouting) return;
+    
     // Get all nodes in network
     cModule *network = getParentModule()->getParentModule();
     if (!network) return;
@@ -153,12 +234,14 @@ void BatRouting::broadcastRouteDiscovery(int destId)
         ArbitraryMobility *otherMob = check_and_cast<ArbitraryMobility*>(otherMobModule);
         
         try {
-            double dist = myMob->getCurrentPosition().distance(otherMob->getCurrentPosition());
-            if (dist < 300.0) { // Communication range 300m
+            const Coord &myPos = myMob->getCurrentPosition();
+            const Coord &otherPos = otherMob->getCurrentPosition();
+            if (isLinkUp(myPos, otherPos)) {
                 RouteDiscoveryPacket *copy = dynamic_cast<RouteDiscoveryPacket*>(pkt->dup());
                 if (copy) {
                     // Send to other UAV's radioIn gate (visible in animation)
                     sendDirect(copy, otherUav, "radioIn");
+                    numRouteRequestsSent++;
                 }
             }
         } catch (const std::exception &e) {
@@ -193,7 +276,7 @@ void BatRouting::processRouteDiscovery(RouteDiscoveryPacket *pkt)
     if (pkt->destId == myNodeId) {
         // Create route info
         RouteInfo route;
-        route.path = pkt->visitedNodes;
+        route.path.assign(pkt->visitedNodes.begin(), pkt->visitedNodes.end());
         route.hopCount = pkt->visitedNodes.size() - 1;
         route.fitness = pkt->accumulatedFitness;
         route.lastUpdate = simTime();
@@ -219,6 +302,7 @@ void BatRouting::processRouteDiscovery(RouteDiscoveryPacket *pkt)
         }
         
         emit(routeDiscoveredSignal, 1);
+        numRoutesDiscovered++;
         EV << "BatRouting: Node " << myNodeId << " - Route discovered from " 
            << pkt->sourceId << " with " << route.hopCount << " hops" << endl;
         
@@ -264,12 +348,14 @@ void BatRouting::processRouteDiscovery(RouteDiscoveryPacket *pkt)
                         ArbitraryMobility *myMob = check_and_cast<ArbitraryMobility*>(myMobModule);
                         ArbitraryMobility *otherMob = check_and_cast<ArbitraryMobility*>(otherMobModule);
                         
-                        double dist = myMob->getCurrentPosition().distance(otherMob->getCurrentPosition());
-                        if (dist < 300.0) {
+                        const Coord &myPos = myMob->getCurrentPosition();
+                        const Coord &otherPos = otherMob->getCurrentPosition();
+                        if (isLinkUp(myPos, otherPos)) {
                             RouteDiscoveryPacket *copy = dynamic_cast<RouteDiscoveryPacket*>(pkt->dup());
                             if (copy) {
                                 // Send to other UAV's radioIn gate (visible in animation)
                                 sendDirect(copy, otherUav, "radioIn");
+                                numRouteRequestsSent++;
                             }
                         }
                     } catch (const std::exception &e) {
@@ -285,6 +371,9 @@ void BatRouting::processRouteDiscovery(RouteDiscoveryPacket *pkt)
 
 void BatRouting::updateRouteTable(int dest, const RouteInfo &route)
 {
+    // Called by the destination's module; the table entries belong to us
+    BAT_ALLOC_SCOPE(allocStats);
+    
     auto &routes = routeTable[dest];
     
     // Add new route
@@ -301,6 +390,13 @@ void BatRouting::updateRouteTable(int dest, const RouteInfo &route)
         routes.resize(maxRoutesPerDestination);
     }
     
+    if (fingerprintRouting) {
+        FINGERPRINT_ADD_EXTRA_DATA(myNodeId);
+        FINGERPRINT_ADD_EXTRA_DATA(dest);
+        FINGERPRINT_ADD_EXTRA_DATA(route.fitness);
+        FINGERPRINT_ADD_EXTRA_DATA(routes[0].fitness);
+    }
+    
     EV << "BatRouting: Node " << myNodeId << " - Updated route to " << dest 
        << " (fitness: " << route.fitness << ")" << endl;
 }
@@ -316,21 +412,257 @@ RouteInfo* BatRouting::selectBestRoute(int dest)
     return &(it->second[0]);
 }
 
+void BatRouting::sendDataPacket()
+{
+    int numNodes = getParentModule()->getParentModule()->getSubmoduleVectorSize("uav");
+    if (numNodes < 2) return;
+    
+    int destId = intuniform(0, numNodes - 2);
+    if (destId >= myNodeId) destId++;
+    
+    char msgName[32];
+    sprintf(msgName, "DATA %d->%d", myNodeId, destId);
+    DataPacket *pkt = new DataPacket(msgName);
+    pkt->sourceId = myNodeId;
+    pkt->destId = destId;
+    pkt->hopsLeft = maxDataHops;
+    
+    if (geographicRouting) {
+        // Location service: the source knows where the destination is now
+        pkt->mode = FORWARD_GREEDY;
+        pkt->destPosition = getMobility(destId)->getCurrentPosition();
+    }
+    
+    numDataSent++;
+    routeDataPacket(pkt);
+}
+
 void BatRouting::routeDataPacket(DataPacket *pkt)
 {
-    // This would be called when receiving data to route
     emit(packetRoutedSignal, 1);
+    numPacketsRouted++;
     
-    RouteInfo *route = selectBestRoute(pkt->destId);
-    if (route) {
+    if (pkt->destId == myNodeId) {
+        emit(dataDeliveredSignal, pkt->hopCount);
+        numDataDelivered++;
+        EV << "BatRouting: Node " << myNodeId << " - Delivered " << pkt->getName()
+           << " after " << pkt->hopCount << " hops" << endl;
+        delete pkt;
+        return;
+    }
+    
+    if (pkt->hopsLeft <= 0) {
+        dropDataPacket(pkt, "hop limit reached");
+        return;
+    }
+    
+    int nextHop;
+    if (geographicRouting && pkt->mode != FORWARD_SOURCE_ROUTE)
+        nextHop = selectGeographicHop(pkt);
+    else
+        nextHop = selectSourceRouteHop(pkt);
+    
+    // A table route that broke on the way: continue geographically from here
+    if (nextHop < 0 && geographicRouting && pkt->mode == FORWARD_SOURCE_ROUTE) {
+        pkt->mode = FORWARD_GREEDY;
+        pkt->routePath.clear();
+        nextHop = selectGeographicHop(pkt);
+    }
+    
+    if (nextHop < 0) {
+        dropDataPacket(pkt, "no next hop");
+        return;
+    }
+    
+    if (fingerprintRouting) {
+        FINGERPRINT_ADD_EXTRA_DATA(myNodeId);
+        FINGERPRINT_ADD_EXTRA_DATA(nextHop);
+    }
+    
+    pkt->prevHop = myNodeId;
+    pkt->hopsLeft--;
+    pkt->hopCount++;
+    numDataForwarded++;
+    
+    EV << "BatRouting: Node " << myNodeId << " - Forwarding " << pkt->getName() << " to " << nextHop
+       << (pkt->mode == FORWARD_GREEDY ? " (greedy)" : pkt->mode == FORWARD_PERIMETER ? " (perimeter)" : " (route)") << endl;
+    
+    cModule *nextUav = getParentModule()->getParentModule()->getSubmodule("uav", nextHop);
+    sendDirect(pkt, nextUav, "radioIn");
+}
+
+int BatRouting::selectSourceRouteHop(DataPacket *pkt)
+{
+    // Pick up a route at the source, or where geographic forwarding fell back
+    if (pkt->mode != FORWARD_SOURCE_ROUTE || pkt->routePath.empty()) {
+        RouteInfo *route = selectBestRoute(pkt->destId);
+        if (!route) {
+            EV << "BatRouting: Node " << myNodeId << " - No route to " << pkt->destId << endl;
+            return -1;
+        }
         pkt->routePath = route->path;
         pkt->currentHop = 0;
+        pkt->mode = FORWARD_SOURCE_ROUTE;
+    }
+    
+    if (pkt->currentHop + 1 >= (int)pkt->routePath.size() || pkt->routePath[pkt->currentHop] != myNodeId)
+        return -1;
+    
+    int nextHop = pkt->routePath[pkt->currentHop + 1];
+    const Coord myPos = getMobility(myNodeId)->getCurrentPosition();
+    const Coord nextPos = getMobility(nextHop)->getCurrentPosition();
+    if (!isLinkUp(myPos, nextPos)) {
+        EV << "BatRouting: Node " << myNodeId << " - Route to " << pkt->destId
+           << " broken at link to " << nextHop << endl;
+        return -1;
+    }
+    
+    pkt->currentHop++;
+    return nextHop;
+}
+
+int BatRouting::selectGeographicHop(DataPacket *pkt)
+{
+    const Coord myPos = getMobility(myNodeId)->getCurrentPosition();
+    std::vector<std::pair<int, Coord>> neighbors = getNeighbors(myPos);
+    
+    // Destination in range: deliver directly, wherever it has moved since
+    for (const auto &neighbor : neighbors) {
+        if (neighbor.first == pkt->destId)
+            return pkt->destId;
+    }
+    
+    // Back to greedy once closer than the point where greedy failed
+    if (pkt->mode == FORWARD_PERIMETER
+        && myPos.distance(pkt->destPosition) < pkt->perimeterEntry.distance(pkt->destPosition))
+        pkt->mode = FORWARD_GREEDY;
+    
+    if (pkt->mode == FORWARD_GREEDY) {
+        int nextHop = selectGreedyHop(myPos, pkt->destPosition, neighbors);
+        if (nextHop >= 0)
+            return nextHop;
+        
+        // Local minimum: follow a table route if there is one and its first
+        // link is still up
+        if (selectBestRoute(pkt->destId)) {
+            nextHop = selectSourceRouteHop(pkt);
+            if (nextHop >= 0)
+                return nextHop;
+            pkt->mode = FORWARD_GREEDY;
+            pkt->routePath.clear();
+        }
         
-        // Forward to next hop (implementation would send via lowerLayerOut)
-        EV << "BatRouting: Node " << myNodeId << " - Routing packet to " 
-           << pkt->destId << " via route with " << route->hopCount << " hops" << endl;
+        // Otherwise request one for later packets (at most once per update
+        // interval and destination) while this one goes around the void
+        auto last = lastOnDemandDiscovery.find(pkt->destId);
+        if (last == lastOnDemandDiscovery.end() || simTime() - last->second >= routingUpdateInterval) {
+            lastOnDemandDiscovery[pkt->destId] = simTime();
+            broadcastRouteDiscovery(pkt->destId);
+        }
+        
+        pkt->mode = FORWARD_PERIMETER;
+        pkt->perimeterEntry = myPos;
+        pkt->perimeterFirstFrom = -1;
+        pkt->perimeterFirstTo = -1;
     }
     
+    return selectPerimeterHop(pkt, myPos, neighbors);
+}
+
+int BatRouting::selectGreedyHop(const Coord &myPos, const Coord &destPos,
+                                const std::vector<std::pair<int, Coord>> &neighbors)
+{
+    // Best progress toward the destination per unit of link cost, so a
+    // slightly shorter step over a much better link wins
+    double myDistance = myPos.distance(destPos);
+    int bestHop = -1;
+    double bestScore = 0;
+    
+    for (const auto &neighbor : neighbors) {
+        double progress = myDistance - neighbor.second.distance(destPos);
+        if (progress <= 0) continue;
+        
+        double linkQuality = calculateLinkQuality(myPos.distance(neighbor.second));
+        double score = progress / calculateLinkCost(linkQuality, neighbor.first);
+        if (score > bestScore) {
+            bestScore = score;
+            bestHop = neighbor.first;
+        }
+    }
+    return bestHop;
+}
+
+// Squared distance in the XY plane (perimeter routing planarizes the projection)
+static double planarDistance2(const Coord &a, const Coord &b)
+{
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+int BatRouting::selectPerimeterHop(DataPacket *pkt, const Coord &myPos,
+                                   const std::vector<std::pair<int, Coord>> &neighbors)
+{
+    // Gabriel graph: keep the edge to v only if no other neighbor lies in
+    // the circle whose diameter is that edge
+    std::vector<const std::pair<int, Coord>*> planarNeighbors;
+    for (const auto &v : neighbors) {
+        Coord middle = (myPos + v.second) / 2;
+        double radius2 = planarDistance2(myPos, v.second) / 4;
+        bool keep = true;
+        for (const auto &w : neighbors) {
+            if (&w != &v && planarDistance2(middle, w.second) < radius2) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep)
+            planarNeighbors.push_back(&v);
+    }
+    if (planarNeighbors.empty())
+        return -1;
+    
+    // Right-hand rule: first edge counterclockwise from the edge the packet
+    // arrived on, or from the line to the destination when entering the face
+    Coord reference = pkt->destPosition;
+    if (pkt->perimeterFirstFrom >= 0) {
+        for (const auto &neighbor : neighbors) {
+            if (neighbor.first == pkt->prevHop)
+                reference = neighbor.second;
+        }
+    }
+    double referenceAngle = atan2(reference.y - myPos.y, reference.x - myPos.x);
+    
+    int nextHop = -1;
+    double bestTurn = 0;
+    for (const auto *neighbor : planarNeighbors) {
+        double turn = atan2(neighbor->second.y - myPos.y, neighbor->second.x - myPos.x) - referenceAngle;
+        while (turn <= 0) turn += 2 * M_PI;
+        while (turn > 2 * M_PI) turn -= 2 * M_PI;
+        if (nextHop < 0 || turn < bestTurn) {
+            bestTurn = turn;
+            nextHop = neighbor->first;
+        }
+    }
+    
+    // Taking the first perimeter edge again means the whole face was
+    // traversed without getting closer: the destination is unreachable
+    if (pkt->perimeterFirstFrom < 0) {
+        pkt->perimeterFirstFrom = myNodeId;
+        pkt->perimeterFirstTo = nextHop;
+    }
+    else if (pkt->perimeterFirstFrom == myNodeId && pkt->perimeterFirstTo == nextHop) {
+        EV << "BatRouting: Node " << myNodeId << " - Perimeter loop, " << pkt->destId << " unreachable" << endl;
+        return -1;
+    }
+    return nextHop;
+}
+
+void BatRouting::dropDataPacket(DataPacket *pkt, const char *reason)
+{
+    EV << "BatRouting: Node " << myNodeId << " - Dropping " << pkt->getName() << ": " << reason << endl;
+    emit(dataDroppedSignal, 1);
+    numDataDropped++;
     delete pkt;
 }
 
@@ -408,10 +740,13 @@ double BatRouting::calculateLinkQuality(int nodeA, int nodeB)
         ArbitraryMobility *mA = check_and_cast<ArbitraryMobility*>(mobA);
         ArbitraryMobility *mB = check_and_cast<ArbitraryMobility*>(mobB);
         
-        double dist = mA->getCurrentPosition().distance(mB->getCurrentPosition());
+        const Coord &posA = mA->getCurrentPosition();
+        const Coord &posB = mB->getCurrentPosition();
+        double quality = calculateLinkQuality(posA.distance(posB));
         
-        // Link quality decreases with distance (1.0 at 0m, 0.0 at 300m)
-        double quality = std::max(0.0, 1.0 - (dist / 300.0));
+        // No line of sight, no link
+        if (quality > 0 && obstacles && obstacles->isLineOfSightBlocked(posA, posB))
+            return 0.0;
         return quality;
     } catch (const std::exception &e) {
         EV_WARN << "BatRouting: Error calculating link quality: " << e.what() << endl;
@@ -419,13 +754,44 @@ double BatRouting::calculateLinkQuality(int nodeA, int nodeB)
     }
 }
 
+double BatRouting::calculateLinkQuality(double distance)
+{
+    // Link quality decreases with distance (1.0 at 0m, 0.0 at commRange)
+    return std::max(0.0, 1.0 - (distance / commRange));
+}
+
+double BatRouting::calculateLinkCost(double linkQuality, int nodeId)
+{
+    // One hop's share of calculateRouteFitness: the hop, its link quality
+    // and the mobility of the node it leads to
+    return hopCountWeight
+        + (1.0 / (linkQuality + 0.1)) * linkQualityWeight
+        + calculateNodeMobility(nodeId) * mobilityWeight;
+}
+
+bool BatRouting::isLinkUp(const Coord &posA, const Coord &posB)
+{
+    // Cheap range test first; only links in range pay for the BVH query
+    if (posA.distance(posB) >= commRange)
+        return false;
+    return !obstacles || !obstacles->isLineOfSightBlocked(posA, posB);
+}
+
+bool BatRouting::isLinkUpForObserver(const Coord &posA, const Coord &posB)
+{
+    // isLinkUp() without counting the BVH query as this node's traffic
+    if (posA.distance(posB) >= commRange)
+        return false;
+    return !obstacles || !obstacles->isLineOfSightBlockedForObserver(posA, posB);
+}
+
 double BatRouting::calculateNodeMobility(int nodeId)
 {
     // Return constant low mobility value
     return 0.1;
 }
 
-void BatRouting::cleanupExpiredRoutes()
+void BatRouting::cleanupExpiredRoutes(simtime_t now)
 {
     for (auto it = routeTable.begin(); it != routeTable.end(); ) {
         auto &routes = it->second;
@@ -433,8 +799,8 @@ void BatRouting::cleanupExpiredRoutes()
         // Remove expired routes
         routes.erase(
             std::remove_if(routes.begin(), routes.end(),
-                [this](const RouteInfo &route) {
-                    return (simTime() - route.lastUpdate) > routeTimeout;
+                [this, now](const RouteInfo &route) {
+                    return (now - route.lastUpdate) > routeTimeout;
                 }),
             routes.end()
         );
@@ -448,6 +814,68 @@ void BatRouting::cleanupExpiredRoutes()
     }
 }
 
+void BatRouting::maintainRouteTable(simtime_t now)
+{
+    // May run on a RoutingEpochCoordinator worker thread: only touches this
+    // node's route table and read-only parameters, never simulation APIs
+    BAT_ALLOC_SCOPE(allocStats);
+    startWallTime();
+    
+    optimizeRouteTable();
+    cleanupExpiredRoutes(now);
+    
+    stopWallTime();
+}
+
+void BatRouting::recordRouteUpdate()
+{
+    if (fingerprintRouting) {
+        FINGERPRINT_ADD_EXTRA_DATA(myNodeId);
+        FINGERPRINT_ADD_EXTRA_DATA(getRouteEntryCount());
+    }
+}
+
+void BatRouting::beginRoutingEpoch()
+{
+    Enter_Method_Silent();
+    BAT_ALLOC_SCOPE(allocStats);
+    startWallTime();
+    
+    discoverRoutes();
+    
+    stopWallTime();
+}
+
+void BatRouting::endRoutingEpoch()
+{
+    Enter_Method_Silent();
+    startWallTime();
+    
+    recordRouteUpdate();
+    
+    stopWallTime();
+}
+
+ArbitraryMobility *BatRouting::getMobility(int nodeId)
+{
+    cModule *uav = getParentModule()->getParentModule()->getSubmodule("uav", nodeId);
+    return check_and_cast<ArbitraryMobility*>(uav->getSubmodule("mobility"));
+}
+
+std::vector<std::pair<int, Coord>> BatRouting::getNeighbors(const Coord &myPos)
+{
+    std::vector<std::pair<int, Coord>> neighbors;
+    int numNodes = getParentModule()->getParentModule()->getSubmoduleVectorSize("uav");
+    for (int i = 0; i < numNodes; i++) {
+        if (i == myNodeId) continue;
+        
+        const Coord otherPos = getMobility(i)->getCurrentPosition();
+        if (isLinkUp(myPos, otherPos))
+            neighbors.push_back(std::make_pair(i, otherPos));
+    }
+    return neighbors;
+}
+
 std::vector<int> BatRouting::getNeighborIds()
 {
     std::vector<int> neighbors;
@@ -473,8 +901,9 @@ std::vector<int> BatRouting::getNeighborIds()
             if (otherMobModule) {
                 ArbitraryMobility *otherMob = check_and_cast<ArbitraryMobility*>(otherMobModule);
                 
-                double dist = myMob->getCurrentPosition().distance(otherMob->getCurrentPosition());
-                if (dist < 300.0) { // Communication range
+                const Coord &myPos = myMob->getCurrentPosition();
+                const Coord &otherPos = otherMob->getCurrentPosition();
+                if (isLinkUp(myPos, otherPos)) {
                     neighbors.push_back(i);
                 }
             }
@@ -484,6 +913,15 @@ std::vector<int> BatRouting::getNeighborIds()
     return neighbors;
 }
 
+int BatRouting::getRouteEntryCount() const
+{
+    int count = 0;
+    for (const auto &entry : routeTable) {
+        count += entry.second.size();
+    }
+    return count;
+}
+
 void BatRouting::finish()
 {
     // Statistics
@@ -494,4 +932,42 @@ void BatRouting::finish()
         EV << "  Destination " << entry.first << ": " 
            << entry.second.size() << " routes" << endl;
     }
+    
+    // Overhead and delivery, for comparing routingMode = table vs. geographic
+    recordScalar("routeRequestsSent", numRouteRequestsSent);
+    recordScalar("dataSent", numDataSent);
+    recordScalar("dataForwarded", numDataForwarded);
+    recordScalar("dataDelivered", numDataDelivered);
+    recordScalar("dataDropped", numDataDropped);
+    if (measureWallTime)
+        recordScalar("routingWallTime", routingWallTime);
+    
+#ifdef BAT_ALLOC_TRACKING
+    recordAllocStats(this, "alloc", allocStats);
+    EV << "BatRouting: Node " << myNodeId << " - Peak live heap: " 
+       << allocStats->peakLiveBytes << " bytes" << endl;
+    
+    // Memory allocated outside any node's scope, once per run on the
+    // network, so the per-node and unowned totals add up
+    if (myNodeId == 0)
+        recordAllocStats(getParentModule()->getParentModule(), "allocUnowned", alloctracker::unownedStats());
+#endif
+}
+
+void BatRouting::recordAllocStats(cComponent *component, const char *prefix, const AllocStats *stats)
+{
+    char name[64];
+    for (int c = 0; c < NUM_ALLOC_CATEGORIES; c++) {
+        const char *category = allocCategoryName(c);
+        sprintf(name, "%s:%s:count", prefix, category);
+        component->recordScalar(name, stats->allocs[c]);
+        sprintf(name, "%s:%s:bytes", prefix, category);
+        component->recordScalar(name, stats->bytes[c]);
+        sprintf(name, "%s:%s:peakLiveBytes", prefix, category);
+        component->recordScalar(name, stats->peakLiveBytesPerCategory[c]);
+    }
+    sprintf(name, "%s:peakLiveBytes", prefix);
+    component->recordScalar(name, stats->peakLiveBytes);
+    sprintf(name, "%s:liveBytesAtFinish", prefix);
+    component->recordScalar(name, stats->totalLiveBytes);
 }
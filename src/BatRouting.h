@@ -7,17 +7,24 @@
 #define __BAT_ALGORITHM_BATROUTING_H_
 
 #include <omnetpp.h>
+#include <chrono>
 #include <vector>
 #include <map>
 #include "inet/common/geometry/common/Coord.h"
 #include "ArbitraryMobility.h"
+#include "AllocTracker.h"
+#include "ObstacleField.h"
 
 using namespace omnetpp;
 using namespace inet;
 
+// Node ID sequences (allocator is std::allocator unless BAT_ALLOC_TRACKING)
+typedef std::vector<int, TrackedAllocator<int, ALLOC_ROUTE_PATH>> NodePath;
+typedef std::vector<int, TrackedAllocator<int, ALLOC_VISITED_NODES>> VisitedNodeList;
+
 // Route information structure
 struct RouteInfo {
-    std::vector<int> path;        // Node IDs in path
+    NodePath path;                // Node IDs in path
     double fitness;               // Route quality metric
     double hopCount;              // Number of hops
     double linkQuality;           // Average link quality
@@ -30,7 +37,9 @@ struct RouteInfo {
 // Packet for route discovery
 class RouteDiscoveryPacket : public cMessage {
   public:
-    std::vector<int> visitedNodes;
+    BAT_TRACKED_NEW(ALLOC_PACKET)
+    
+    VisitedNodeList visitedNodes;
     int sourceId;
     int destId;
     double accumulatedFitness;
@@ -48,18 +57,43 @@ class RouteDiscoveryPacket : public cMessage {
     }
 };
 
+// How a data packet is currently being forwarded
+enum ForwardingMode {
+    FORWARD_GREEDY,       // Geographic: best weighted progress toward destPosition
+    FORWARD_PERIMETER,    // Geographic: right-hand rule around a void
+    FORWARD_SOURCE_ROUTE  // Along routePath from the route table
+};
+
 // Data packet with routing info
 class DataPacket : public cMessage {
   public:
+    BAT_TRACKED_NEW(ALLOC_PACKET)
+    
     int sourceId;
     int destId;
-    int currentHop;
-    std::vector<int> routePath;
+    int currentHop;               // Index of the current node in routePath
+    NodePath routePath;
+    int hopsLeft;                 // Dropped when it reaches 0
+    int hopCount;                 // Hops taken so far
+    
+    // Geographic forwarding state
+    ForwardingMode mode;
+    Coord destPosition;           // Destination position when the packet was sent
+    Coord perimeterEntry;         // Where greedy forwarding failed
+    int prevHop;                  // Node the packet came from (-1 at the source)
+    int perimeterFirstFrom;       // First perimeter edge, for loop detection
+    int perimeterFirstTo;
     
     DataPacket(const char *name=nullptr) : cMessage(name) {
         sourceId = -1;
         destId = -1;
         currentHop = 0;
+        hopsLeft = 0;
+        hopCount = 0;
+        mode = FORWARD_SOURCE_ROUTE;
+        prevHop = -1;
+        perimeterFirstFrom = -1;
+        perimeterFirstTo = -1;
         setKind(2); // Data packet type
     }
     
@@ -70,6 +104,12 @@ class DataPacket : public cMessage {
 
 class BatRouting : public cSimpleModule
 {
+  public:
+    // Route table: destination -> list of routes, best first
+    typedef std::vector<RouteInfo, TrackedAllocator<RouteInfo, ALLOC_ROUTE_LIST>> RouteList;
+    typedef std::map<int, RouteList, std::less<int>,
+                     TrackedAllocator<std::pair<const int, RouteList>, ALLOC_ROUTE_TABLE>> RouteTable;
+    
   private:
     // Bat Algorithm parameters
     double frequencyMin, frequencyMax;
@@ -83,9 +123,20 @@ class BatRouting : public cSimpleModule
     double energyWeight, mobilityWeight;
     int maxRoutesPerDestination;
     double routeTimeout;
+    bool fingerprintRouting;
+    bool synchronizedEpochs;
+    double commRange;
+    
+    // Forwarding: table-driven (source routes from discovery) or geographic
+    bool geographicRouting;
+    int maxDataHops;
+    double dataInterval;          // Generated traffic; 0 = none
+    std::map<int, simtime_t> lastOnDemandDiscovery;
+    
+    // Obstacle model (nullptr if line of sight is not checked)
+    ObstacleField *obstacles;
     
-    // Route table: destination -> list of routes
-    std::map<int, std::vector<RouteInfo>> routeTable;
+    RouteTable routeTable;
     
     // Neighbor information
     std::map<int, Coord> neighborPositions;
@@ -94,9 +145,30 @@ class BatRouting : public cSimpleModule
     // Statistics
     simsignal_t routeDiscoveredSignal;
     simsignal_t packetRoutedSignal;
+    simsignal_t dataDeliveredSignal;
+    simsignal_t dataDroppedSignal;
+    long numRouteRequestsSent;
+    long numRoutesDiscovered;
+    long numPacketsRouted;
+    long numDataSent;
+    long numDataForwarded;
+    long numDataDelivered;
+    long numDataDropped;
+    
+    // Wall time spent in this node's routing code (s), only if measureWallTime
+    bool measureWallTime;
+    double routingWallTime;
+    int wallTimeDepth;            // Nested startWallTime() calls
+    std::chrono::steady_clock::time_point wallTimeStart;
+    
+#ifdef BAT_ALLOC_TRACKING
+    // Allocation accounting for this instance (see AllocTracker.h)
+    AllocStats *allocStats;
+#endif
     
     // Messages
     cMessage *routeUpdateTimer;
+    cMessage *dataTimer;
     
     // My node ID
     int myNodeId;
@@ -112,6 +184,12 @@ class BatRouting : public cSimpleModule
     void updateRouteTable(int dest, const RouteInfo &route);
     RouteInfo* selectBestRoute(int dest);
     void routeDataPacket(DataPacket *pkt);
+    void sendDataPacket();
+    int selectSourceRouteHop(DataPacket *pkt);
+    int selectGeographicHop(DataPacket *pkt);
+    int selectGreedyHop(const Coord &myPos, const Coord &destPos, const std::vector<std::pair<int, Coord>> &neighbors);
+    int selectPerimeterHop(DataPacket *pkt, const Coord &myPos, const std::vector<std::pair<int, Coord>> &neighbors);
+    void dropDataPacket(DataPacket *pkt, const char *reason);
     
     // Bat Algorithm for route optimization
     double calculateRouteFitness(const RouteInfo &route);
@@ -121,8 +199,14 @@ class BatRouting : public cSimpleModule
     // Helper functions
     double calculateLinkQuality(int nodeA, int nodeB);
     double calculateNodeMobility(int nodeId);
+    ArbitraryMobility *getMobility(int nodeId);
+    std::vector<std::pair<int, Coord>> getNeighbors(const Coord &myPos);
     void broadcastRouteDiscovery(int destId);
-    void cleanupExpiredRoutes();
+    void cleanupExpiredRoutes(simtime_t now);
+    void recordRouteUpdate();
+    static void recordAllocStats(cComponent *component, const char *prefix, const AllocStats *stats);
+    void startWallTime();
+    void stopWallTime();
     
   public:
     BatRouting();
@@ -131,6 +215,32 @@ class BatRouting : public cSimpleModule
     // Public interface for other modules
     int getMyNodeId() const { return myNodeId; }
     std::vector<int> getNeighborIds();
+    
+    // Synchronized routing epochs (driven by RoutingEpochCoordinator).
+    // begin/end run on the simulation thread; maintainRouteTable() only
+    // touches this node's table and may run on a worker thread.
+    bool usesSynchronizedEpochs() const { return synchronizedEpochs; }
+    void beginRoutingEpoch();
+    void maintainRouteTable(simtime_t now);
+    void endRoutingEpoch();
+    
+    // Read-only counters (used by SwarmTelemetry)
+    int getRouteTableSize() const { return routeTable.size(); }
+    int getRouteEntryCount() const;
+    long getRouteRequestsSent() const { return numRouteRequestsSent; }
+    long getRoutesDiscovered() const { return numRoutesDiscovered; }
+    long getPacketsRouted() const { return numPacketsRouted; }
+    bool usesGeographicRouting() const { return geographicRouting; }
+    
+    // Read-only route table (used by RouteOracle)
+    const RouteTable& getRouteTable() const { return routeTable; }
+    
+    // Link model (also used by RouteOracle to rebuild the topology)
+    double calculateLinkQuality(double distance);
+    double calculateLinkCost(double linkQuality, int nodeId);
+    bool isLinkUp(const Coord &posA, const Coord &posB);
+    bool isLinkUpForObserver(const Coord &posA, const Coord &posB);
+    double getCommRange() const { return commRange; }
 };
 
 #endif
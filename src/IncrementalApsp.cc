@@ -0,0 +1,185 @@
+//
+// IncrementalApsp.cc
+// Implementation of incrementally maintained all-pairs shortest paths
+//
+
+#include "IncrementalApsp.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+typedef std::pair<double, int> QueueEntry;
+typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> MinQueue;
+
+// nodeState values while repairing one source
+enum { NODE_UNKNOWN = 0, NODE_VALID, NODE_INVALID };
+
+IncrementalApsp::IncrementalApsp()
+{
+    numNodes = 0;
+    numSourcesRepaired = 0;
+    numNodesInvalidated = 0;
+    numFullRuns = 0;
+}
+
+void IncrementalApsp::reset(int numNodes)
+{
+    this->numNodes = numNodes;
+    weights.assign(numNodes * numNodes, NO_EDGE);
+    outEdges.assign(numNodes, std::vector<int>());
+    inEdges.assign(numNodes, std::vector<int>());
+    distances.assign(numNodes * numNodes, NO_EDGE);
+    parents.assign(numNodes * numNodes, -1);
+    for (int s = 0; s < numNodes; s++)
+        distances[s * numNodes + s] = 0;
+    pendingChanges.clear();
+    pendingFlags.assign(numNodes * numNodes, 0);
+    nodeState.assign(numNodes, NODE_UNKNOWN);
+}
+
+void IncrementalApsp::setWeight(int from, int to, double weight)
+{
+    double &current = weights[from * numNodes + to];
+    if (weight == current)
+        return;
+
+    // Remember the weight before the first change in this batch only
+    if (!pendingFlags[from * numNodes + to]) {
+        pendingFlags[from * numNodes + to] = 1;
+        pendingChanges.push_back(EdgeChange{from, to, current});
+    }
+
+    if (current == NO_EDGE) {
+        outEdges[from].push_back(to);
+        inEdges[to].push_back(from);
+    }
+    else if (weight == NO_EDGE) {
+        outEdges[from].erase(std::find(outEdges[from].begin(), outEdges[from].end(), to));
+        inEdges[to].erase(std::find(inEdges[to].begin(), inEdges[to].end(), from));
+    }
+    current = weight;
+}
+
+void IncrementalApsp::update()
+{
+    if (pendingChanges.empty())
+        return;
+
+    for (int s = 0; s < numNodes; s++)
+        repairSource(s);
+
+    for (const EdgeChange &change : pendingChanges)
+        pendingFlags[change.from * numNodes + change.to] = 0;
+    pendingChanges.clear();
+}
+
+bool IncrementalApsp::isInvalidated(const int *parent, int node)
+{
+    // Walk up the tree until a node with known state; everything on the
+    // way shares it. Amortized O(1) per node over one source.
+    while (nodeState[node] == NODE_UNKNOWN) {
+        walkStack.push_back(node);
+        node = parent[node];
+        if (node < 0) {
+            node = walkStack.back();    // Unreachable (or the source): valid
+            nodeState[node] = NODE_VALID;
+        }
+    }
+    char state = nodeState[node];
+    for (int n : walkStack)
+        nodeState[n] = state;
+    walkStack.clear();
+    return state == NODE_INVALID;
+}
+
+void IncrementalApsp::repairSource(int source)
+{
+    double *dist = &distances[source * numNodes];
+    int *parent = &parents[source * numNodes];
+
+    // Tree edges that got worse cut off the subtree below them; parents
+    // still describe the tree from before this batch
+    bool anyInvalid = false;
+    for (const EdgeChange &change : pendingChanges) {
+        if (getWeight(change.from, change.to) > change.oldWeight && parent[change.to] == change.from) {
+            nodeState[change.to] = NODE_INVALID;
+            anyInvalid = true;
+        }
+    }
+
+    MinQueue queue;
+    if (anyInvalid) {
+        nodeState[source] = NODE_VALID;
+        for (int n = 0; n < numNodes; n++) {
+            if (isInvalidated(parent, n))
+                invalidated.push_back(n);
+        }
+        for (int n : invalidated) {
+            dist[n] = NO_EDGE;
+            parent[n] = -1;
+        }
+        numNodesInvalidated += invalidated.size();
+
+        if ((int)invalidated.size() * 2 > numNodes) {
+            // Most of the tree is gone: plain Dijkstra is cheaper than
+            // reseeding (decreases are picked up along the way)
+            std::fill(dist, dist + numNodes, NO_EDGE);
+            std::fill(parent, parent + numNodes, -1);
+            dist[source] = 0;
+            queue.push(QueueEntry(0, source));
+            numFullRuns++;
+            invalidated.clear();
+        }
+
+        // Reseed each invalidated node from its best unaffected in-neighbor
+        for (int n : invalidated) {
+            for (int m : inEdges[n]) {
+                if (nodeState[m] == NODE_INVALID) continue;
+                double d = dist[m] + weights[m * numNodes + n];
+                if (d < dist[n]) {
+                    dist[n] = d;
+                    parent[n] = m;
+                }
+            }
+            if (dist[n] != NO_EDGE)
+                queue.push(QueueEntry(dist[n], n));
+        }
+        invalidated.clear();
+        std::fill(nodeState.begin(), nodeState.end(), NODE_UNKNOWN);
+    }
+
+    // Cheaper or new edges seed the nodes they bring closer
+    for (const EdgeChange &change : pendingChanges) {
+        double weight = getWeight(change.from, change.to);
+        if (weight >= change.oldWeight)
+            continue;
+        double d = dist[change.from] + weight;
+        if (d < dist[change.to]) {
+            dist[change.to] = d;
+            parent[change.to] = change.from;
+            queue.push(QueueEntry(d, change.to));
+        }
+    }
+
+    if (queue.empty() && !anyInvalid)
+        return;
+
+    // Labels are upper bounds and exact outside the seeded region, so one
+    // Dijkstra pass from the seeds makes them exact everywhere
+    while (!queue.empty()) {
+        QueueEntry top = queue.top();
+        queue.pop();
+        int u = top.second;
+        if (top.first > dist[u]) continue;
+        for (int v : outEdges[u]) {
+            double d = top.first + weights[u * numNodes + v];
+            if (d < dist[v]) {
+                dist[v] = d;
+                parent[v] = u;
+                queue.push(QueueEntry(d, v));
+            }
+        }
+    }
+    numSourcesRepaired++;
+}
@@ -0,0 +1,84 @@
+//
+// IncrementalApsp.h
+// All-pairs shortest paths maintained under edge insertions, removals and
+// weight changes
+//
+
+#ifndef __BAT_ALGORITHM_INCREMENTALAPSP_H_
+#define __BAT_ALGORITHM_INCREMENTALAPSP_H_
+
+#include <limits>
+#include <vector>
+
+//
+// Directed graph with non-negative weights and a shortest-path tree per
+// source. Edge changes are staged with setWeight() and applied together by
+// update(), which repairs each source's tree only where it can change:
+//  - weight increase / removal of a tree edge (u,v): the subtree below v is
+//    invalidated and reseeded from its unaffected in-neighbors
+//  - weight decrease / insertion of (u,v): v is seeded if it gets closer
+// followed by one Dijkstra-style pass from the seeds, which only visits
+// nodes whose distance changes. Sources untouched by the batch cost
+// O(changes); if more than half of a tree is invalidated, that source is
+// recomputed from scratch instead.
+//
+// Memory is O(N^2) (distance and parent matrices).
+//
+class IncrementalApsp
+{
+  public:
+    static constexpr double NO_EDGE = std::numeric_limits<double>::infinity();
+
+  private:
+    struct EdgeChange {
+        int from;
+        int to;
+        double oldWeight;
+    };
+
+    int numNodes;
+    std::vector<double> weights;            // numNodes x numNodes, NO_EDGE if absent
+    std::vector<std::vector<int>> outEdges; // Adjacency lists of the same graph
+    std::vector<std::vector<int>> inEdges;
+    std::vector<double> distances;          // Row per source
+    std::vector<int> parents;               // Row per source, -1 = none
+    std::vector<EdgeChange> pendingChanges;
+    std::vector<char> pendingFlags;         // Edge already in pendingChanges
+
+    // Scratch space for repairSource()
+    std::vector<char> nodeState;
+    std::vector<int> walkStack;
+    std::vector<int> invalidated;
+
+    long numSourcesRepaired;
+    long numNodesInvalidated;
+    long numFullRuns;
+
+    void repairSource(int source);
+    bool isInvalidated(const int *parent, int node);
+
+  public:
+    IncrementalApsp();
+
+    // Removes all edges
+    void reset(int numNodes);
+
+    // Stages a change; NO_EDGE removes the edge
+    void setWeight(int from, int to, double weight);
+
+    // Applies staged changes and repairs the affected shortest paths
+    void update();
+
+    int getNumNodes() const { return numNodes; }
+    double getWeight(int from, int to) const { return weights[from * numNodes + to]; }
+    const std::vector<int>& getOutEdges(int from) const { return outEdges[from]; }
+    double getDistance(int source, int target) const { return distances[source * numNodes + target]; }
+
+    // Sources whose tree changed, and tree nodes invalidated by worse
+    // edges (a full recomputation would touch every node of every source)
+    long getNumSourcesRepaired() const { return numSourcesRepaired; }
+    long getNumNodesInvalidated() const { return numNodesInvalidated; }
+    long getNumFullRuns() const { return numFullRuns; }
+};
+
+#endif
@@ -0,0 +1,119 @@
+//
+// MobilityTrace.cc
+// Implementation of memory-mapped trace replay
+//
+
+#include "MobilityTrace.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace battrace;
+
+MobilityTrace::MobilityTrace(const std::string &fileName) : fileName(fileName)
+{
+    data = nullptr;
+    size = 0;
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw cRuntimeError("MobilityTrace: Cannot open trace file '%s': %s", fileName.c_str(), strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TraceHeader)) {
+        close(fd);
+        throw cRuntimeError("MobilityTrace: '%s' is too small to be a trace file", fileName.c_str());
+    }
+    size = st.st_size;
+
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        throw cRuntimeError("MobilityTrace: mmap('%s') failed: %s", fileName.c_str(), strerror(errno));
+    }
+
+    header = static_cast<const TraceHeader*>(data);
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header->version != TRACE_VERSION)
+        throw cRuntimeError("MobilityTrace: '%s' is not a version %u trace file (convert it with tools/trace_convert)",
+                            fileName.c_str(), TRACE_VERSION);
+    if (size < traceFileSize(header->numTracks, header->numSamples))
+        throw cRuntimeError("MobilityTrace: '%s' is truncated", fileName.c_str());
+
+    const char *base = static_cast<const char*>(data);
+    tracks = reinterpret_cast<const TraceTrack*>(base + tracksOffset());
+    samples = reinterpret_cast<const TraceSample*>(base + samplesOffset(header->numTracks));
+
+    for (uint32_t i = 0; i < header->numTracks; i++) {
+        if (tracks[i].firstSample + tracks[i].numSamples > header->numSamples)
+            throw cRuntimeError("MobilityTrace: '%s' track %u points outside the sample array", fileName.c_str(), i);
+    }
+}
+
+MobilityTrace::~MobilityTrace()
+{
+    if (data)
+        munmap(data, size);
+}
+
+std::shared_ptr<const MobilityTrace> MobilityTrace::open(const std::string &fileName)
+{
+    // Mobility modules are initialized on the simulation thread only.
+    // Entries expire when the last replaying module is deleted.
+    static std::map<std::string, std::weak_ptr<const MobilityTrace>> openTraces;
+
+    std::shared_ptr<const MobilityTrace> trace = openTraces[fileName].lock();
+    if (!trace) {
+        trace.reset(new MobilityTrace(fileName));
+        openTraces[fileName] = trace;
+    }
+    return trace;
+}
+
+const TraceSample *MobilityTrace::getTrack(int track, uint32_t &numSamples) const
+{
+    if (track < 0 || track >= (int)header->numTracks) {
+        numSamples = 0;
+        return nullptr;
+    }
+    numSamples = tracks[track].numSamples;
+    return samples + tracks[track].firstSample;
+}
+
+void TraceCursor::attach(const MobilityTrace &trace, int track)
+{
+    samples = trace.getTrack(track, numSamples);
+    if (!samples || numSamples == 0)
+        throw cRuntimeError("MobilityTrace: '%s' has no waypoints for UAV %d", trace.getFileName().c_str(), track);
+    index = 0;
+}
+
+void TraceCursor::getState(double t, Coord &position, Coord &velocity)
+{
+    if (t < samples[index].t && index > 0) {
+        // Went back in time: binary search for the last sample at or before t
+        const TraceSample *it = std::upper_bound(samples, samples + numSamples, t,
+            [](double time, const TraceSample &s) { return time < s.t; });
+        index = it == samples ? 0 : (it - samples) - 1;
+    }
+    while (index + 1 < numSamples && samples[index + 1].t <= t)
+        index++;
+
+    const TraceSample &a = samples[index];
+    if (t < a.t || index + 1 >= numSamples) {
+        position = Coord(a.x, a.y, a.z);
+        velocity = Coord(0, 0, 0);
+        return;
+    }
+
+    const TraceSample &b = samples[index + 1];
+    double dt = b.t - a.t;
+    double f = (t - a.t) / dt;
+    position = Coord(a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f, a.z + (b.z - a.z) * f);
+    velocity = Coord((b.x - a.x) / dt, (b.y - a.y) / dt, (b.z - a.z) / dt);
+}
@@ -0,0 +1,70 @@
+//
+// MobilityTrace.h
+// Memory-mapped mobility trace with per-UAV interpolation cursors
+//
+
+#ifndef __BAT_ALGORITHM_MOBILITYTRACE_H_
+#define __BAT_ALGORITHM_MOBILITYTRACE_H_
+
+#include <omnetpp.h>
+#include <memory>
+#include <string>
+#include "inet/common/geometry/common/Coord.h"
+#include "TraceFormat.h"
+
+using namespace omnetpp;
+using namespace inet;
+
+//
+// Read-only view of a trace file. The file is mapped, never copied to the
+// heap, and one mapping is shared by all modules replaying the same file.
+//
+class MobilityTrace
+{
+  private:
+    std::string fileName;
+    void *data;
+    size_t size;
+    const battrace::TraceHeader *header;
+    const battrace::TraceTrack *tracks;
+    const battrace::TraceSample *samples;
+
+    explicit MobilityTrace(const std::string &fileName);
+
+  public:
+    ~MobilityTrace();
+    MobilityTrace(const MobilityTrace&) = delete;
+    MobilityTrace& operator=(const MobilityTrace&) = delete;
+
+    // Returns the shared mapping of fileName, opening it on first use
+    static std::shared_ptr<const MobilityTrace> open(const std::string &fileName);
+
+    int getNumTracks() const { return header->numTracks; }
+    const battrace::TraceSample *getTrack(int track, uint32_t &numSamples) const;
+    const std::string& getFileName() const { return fileName; }
+};
+
+//
+// Position of one UAV along its track. Queries with non-decreasing times
+// (the normal case in a simulation) cost O(1) amortized; going back in time
+// falls back to a binary search.
+//
+class TraceCursor
+{
+  private:
+    const battrace::TraceSample *samples;
+    uint32_t numSamples;
+    uint32_t index;           // samples[index].t <= last query time, if possible
+
+  public:
+    TraceCursor() : samples(nullptr), numSamples(0), index(0) {}
+
+    void attach(const MobilityTrace &trace, int track);
+    bool isAttached() const { return samples != nullptr; }
+
+    // Linear interpolation between waypoints. Before the first and after the
+    // last waypoint the UAV hovers there with zero velocity.
+    void getState(double t, Coord &position, Coord &velocity);
+};
+
+#endif
@@ -0,0 +1,238 @@
+//
+// ObstacleBvh.cc
+// BVH construction and segment queries
+//
+
+#include "ObstacleBvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+double axisOf(const Coord &c, int axis)
+{
+    return axis == 0 ? c.x : (axis == 1 ? c.y : c.z);
+}
+
+// Slab test of segment from + t*dir, t in [0,1], against a box.
+// On success returns the entry parameter and the axis of the entry face.
+bool segmentHitsBox(const Coord &from, const Coord &invDir, const ObstacleBox &box,
+                    double &tEnter, int &enterAxis)
+{
+    double tMin = 0.0;
+    double tMax = 1.0;
+    enterAxis = -1;
+
+    for (int axis = 0; axis < 3; axis++) {
+        double origin = axisOf(from, axis);
+        double inv = axisOf(invDir, axis);
+        double lo = axisOf(box.min, axis);
+        double hi = axisOf(box.max, axis);
+
+        if (std::isinf(inv)) {
+            // Segment parallel to this slab: must already be inside it
+            if (origin < lo || origin > hi)
+                return false;
+            continue;
+        }
+
+        double t1 = (lo - origin) * inv;
+        double t2 = (hi - origin) * inv;
+        if (t1 > t2)
+            std::swap(t1, t2);
+        if (t1 > tMin) {
+            tMin = t1;
+            enterAxis = axis;
+        }
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax)
+            return false;
+    }
+
+    tEnter = tMin;
+    return true;
+}
+
+bool boxContains(const ObstacleBox &box, const Coord &p)
+{
+    return p.x >= box.min.x && p.x <= box.max.x
+        && p.y >= box.min.y && p.y <= box.max.y
+        && p.z >= box.min.z && p.z <= box.max.z;
+}
+
+} // namespace
+
+void ObstacleBvh::build(const std::vector<ObstacleBox> &obstacles)
+{
+    boxes = obstacles;
+    nodes.clear();
+    depth = 0;
+
+    if (boxes.empty()) return;
+
+    nodes.reserve(2 * boxes.size() / MAX_LEAF_SIZE + 1);
+    buildNode(0, boxes.size(), 1);
+}
+
+int ObstacleBvh::buildNode(int first, int count, int level)
+{
+    depth = std::max(depth, level);
+
+    int index = nodes.size();
+    nodes.push_back(Node());
+
+    // Bounds of all boxes and of their centers
+    ObstacleBox bounds = boxes[first];
+    Coord centerMin = boxes[first].center();
+    Coord centerMax = centerMin;
+    for (int i = first + 1; i < first + count; i++) {
+        const ObstacleBox &b = boxes[i];
+        Coord c = b.center();
+        bounds.min = Coord(std::min(bounds.min.x, b.min.x), std::min(bounds.min.y, b.min.y), std::min(bounds.min.z, b.min.z));
+        bounds.max = Coord(std::max(bounds.max.x, b.max.x), std::max(bounds.max.y, b.max.y), std::max(bounds.max.z, b.max.z));
+        centerMin = Coord(std::min(centerMin.x, c.x), std::min(centerMin.y, c.y), std::min(centerMin.z, c.z));
+        centerMax = Coord(std::max(centerMax.x, c.x), std::max(centerMax.y, c.y), std::max(centerMax.z, c.z));
+    }
+    nodes[index].bounds = bounds;
+
+    Coord extent = centerMax - centerMin;
+    if (count <= MAX_LEAF_SIZE || (extent.x == 0 && extent.y == 0 && extent.z == 0)) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        nodes[index].secondChild = -1;
+        return index;
+    }
+
+    // Median split along the axis with the widest spread of centers
+    int axis = 0;
+    if (extent.y > extent.x) axis = 1;
+    if (extent.z > axisOf(extent, axis)) axis = 2;
+
+    int mid = first + count / 2;
+    std::nth_element(boxes.begin() + first, boxes.begin() + mid, boxes.begin() + first + count,
+        [axis](const ObstacleBox &a, const ObstacleBox &b) {
+            return axisOf(a.center(), axis) < axisOf(b.center(), axis);
+        });
+
+    nodes[index].first = -1;
+    nodes[index].count = 0;
+    buildNode(first, mid - first, level + 1);
+    int second = buildNode(mid, first + count - mid, level + 1);
+    nodes[index].secondChild = second;
+    return index;
+}
+
+bool ObstacleBvh::traverse(const Coord &from, const Coord &to, bool anyHit,
+                           double &hitT, int &hitAxis, BvhQueryStats &stats) const
+{
+    stats.queries++;
+    if (nodes.empty()) return false;
+
+    Coord dir = to - from;
+    const double inf = std::numeric_limits<double>::infinity();
+    Coord invDir(dir.x != 0 ? 1.0 / dir.x : inf,
+                 dir.y != 0 ? 1.0 / dir.y : inf,
+                 dir.z != 0 ? 1.0 / dir.z : inf);
+
+    bool hit = false;
+    hitT = 1.0;
+    hitAxis = -1;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        int index = stack[--top];
+        const Node &node = nodes[index];
+        stats.nodesVisited++;
+
+        double tNode;
+        int axisNode;
+        if (!segmentHitsBox(from, invDir, node.bounds, tNode, axisNode) || tNode > hitT)
+            continue;
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                stats.boxTests++;
+                double t;
+                int axis;
+                if (segmentHitsBox(from, invDir, boxes[i], t, axis) && t <= hitT) {
+                    hit = true;
+                    hitT = t;
+                    hitAxis = axis;
+                    if (anyHit) {
+                        stats.hits++;
+                        return true;
+                    }
+                }
+            }
+        }
+        else {
+            // Depth is logarithmic in the obstacle count, 64 levels is ample
+            stack[top++] = node.secondChild;
+            stack[top++] = index + 1;
+        }
+    }
+
+    if (hit) stats.hits++;
+    return hit;
+}
+
+bool ObstacleBvh::intersectsSegment(const Coord &from, const Coord &to, BvhQueryStats &stats) const
+{
+    double t;
+    int axis;
+    return traverse(from, to, true, t, axis, stats);
+}
+
+bool ObstacleBvh::findContainingBox(const Coord &point, ObstacleBox &box) const
+{
+    if (nodes.empty()) return false;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        int index = stack[--top];
+        const Node &node = nodes[index];
+        if (!boxContains(node.bounds, point))
+            continue;
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                if (boxContains(boxes[i], point)) {
+                    box = boxes[i];
+                    return true;
+                }
+            }
+        }
+        else {
+            stack[top++] = node.secondChild;
+            stack[top++] = index + 1;
+        }
+    }
+    return false;
+}
+
+bool ObstacleBvh::findFirstHit(const Coord &from, const Coord &to, double &t, Coord &normal,
+                               BvhQueryStats &stats) const
+{
+    int axis;
+    if (!traverse(from, to, false, t, axis, stats))
+        return false;
+
+    // Face normal points against the direction of travel on the entry axis.
+    // axis == -1 means the segment starts inside a box; push back along -dir.
+    Coord dir = to - from;
+    normal = Coord(0, 0, 0);
+    if (axis == 0) normal.x = dir.x > 0 ? -1 : 1;
+    else if (axis == 1) normal.y = dir.y > 0 ? -1 : 1;
+    else if (axis == 2) normal.z = dir.z > 0 ? -1 : 1;
+    else {
+        double len = dir.length();
+        if (len > 0) normal = dir * (-1.0 / len);
+    }
+    return true;
+}
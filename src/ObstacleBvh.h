@@ -0,0 +1,81 @@
+//
+// ObstacleBvh.h
+// Bounding-volume hierarchy over axis-aligned box obstacles
+//
+
+#ifndef __BAT_ALGORITHM_OBSTACLEBVH_H_
+#define __BAT_ALGORITHM_OBSTACLEBVH_H_
+
+#include <vector>
+#include "inet/common/geometry/common/Coord.h"
+
+using namespace inet;
+
+// Axis-aligned box (buildings, terrain blocks)
+struct ObstacleBox {
+    Coord min;
+    Coord max;
+
+    ObstacleBox() {}
+    ObstacleBox(const Coord &min, const Coord &max) : min(min), max(max) {}
+    Coord center() const { return (min + max) / 2; }
+};
+
+// Traversal cost counters, accumulated over all queries
+struct BvhQueryStats {
+    long queries;
+    long hits;
+    long nodesVisited;
+    long boxTests;
+
+    BvhQueryStats() : queries(0), hits(0), nodesVisited(0), boxTests(0) {}
+};
+
+class ObstacleBvh
+{
+  private:
+    // Flattened tree node. Inner nodes have count == 0 and their children at
+    // index+1 and secondChild; leaves reference boxes[first, first+count).
+    struct Node {
+        ObstacleBox bounds;
+        int secondChild;
+        int first;
+        int count;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<ObstacleBox> boxes;   // Reordered so each leaf is contiguous
+    int depth;
+
+    static const int MAX_LEAF_SIZE = 4;
+
+    int buildNode(int first, int count, int level);
+    bool traverse(const Coord &from, const Coord &to, bool anyHit,
+                  double &hitT, int &hitAxis, BvhQueryStats &stats) const;
+
+  public:
+    ObstacleBvh() : depth(0) {}
+
+    void build(const std::vector<ObstacleBox> &obstacles);
+    bool empty() const { return boxes.empty(); }
+
+    // Segment queries add their traversal cost to the caller's stats, so
+    // each kind of query can be accounted for separately.
+
+    // True if the segment from -> to passes through any obstacle
+    bool intersectsSegment(const Coord &from, const Coord &to, BvhQueryStats &stats) const;
+
+    // Nearest obstacle crossed by from -> to. On a hit, t is the segment
+    // parameter in [0,1] of the entry point and normal the face normal.
+    bool findFirstHit(const Coord &from, const Coord &to, double &t, Coord &normal, BvhQueryStats &stats) const;
+
+    // Obstacle containing the point (faces included). Not counted: stats
+    // describe segment queries only.
+    bool findContainingBox(const Coord &point, ObstacleBox &box) const;
+
+    int getNumObstacles() const { return boxes.size(); }
+    int getNumNodes() const { return nodes.size(); }
+    int getDepth() const { return depth; }
+};
+
+#endif
@@ -0,0 +1,112 @@
+//
+// ObstacleField.cc
+// Implementation of the BVH-backed obstacle model
+//
+
+#include "ObstacleField.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+Define_Module(ObstacleField);
+
+ObstacleField::ObstacleField()
+{
+}
+
+void ObstacleField::initialize()
+{
+    loadObstacles(par("obstacleFile").stringValue());
+
+    EV << "ObstacleField: Loaded " << bvh.getNumObstacles() << " obstacles into BVH with "
+       << bvh.getNumNodes() << " nodes (depth " << bvh.getDepth() << ")" << endl;
+}
+
+void ObstacleField::handleMessage(cMessage *msg)
+{
+    throw cRuntimeError("ObstacleField: This module does not process messages");
+}
+
+void ObstacleField::loadObstacles(const char *fileName)
+{
+    std::ifstream in(fileName);
+    if (!in)
+        throw cRuntimeError("ObstacleField: Cannot open obstacle file '%s'", fileName);
+
+    std::vector<ObstacleBox> boxes;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind))
+            continue;
+
+        if (kind == "box") {
+            double x1, y1, z1, x2, y2, z2;
+            if (!(fields >> x1 >> y1 >> z1 >> x2 >> y2 >> z2))
+                throw cRuntimeError("ObstacleField: %s:%d: expected 'box minX minY minZ maxX maxY maxZ'", fileName, lineNumber);
+            boxes.push_back(ObstacleBox(Coord(std::min(x1, x2), std::min(y1, y2), std::min(z1, z2)),
+                                        Coord(std::max(x1, x2), std::max(y1, y2), std::max(z1, z2))));
+        }
+        else if (kind == "building") {
+            double cx, cy, width, depth, height;
+            if (!(fields >> cx >> cy >> width >> depth >> height) || width <= 0 || depth <= 0 || height <= 0)
+                throw cRuntimeError("ObstacleField: %s:%d: expected 'building centerX centerY width depth height'", fileName, lineNumber);
+            boxes.push_back(ObstacleBox(Coord(cx - width / 2, cy - depth / 2, 0),
+                                        Coord(cx + width / 2, cy + depth / 2, height)));
+        }
+        else {
+            throw cRuntimeError("ObstacleField: %s:%d: unknown obstacle type '%s'", fileName, lineNumber, kind.c_str());
+        }
+    }
+
+    bvh.build(boxes);
+}
+
+bool ObstacleField::isLineOfSightBlocked(const Coord &from, const Coord &to)
+{
+    return bvh.intersectsSegment(from, to, lineOfSightStats);
+}
+
+bool ObstacleField::isLineOfSightBlockedForObserver(const Coord &from, const Coord &to)
+{
+    return bvh.intersectsSegment(from, to, observerStats);
+}
+
+bool ObstacleField::findFirstHit(const Coord &from, const Coord &to, double &t, Coord &normal)
+{
+    return bvh.findFirstHit(from, to, t, normal, movementStats);
+}
+
+void ObstacleField::recordQueryStats(const char *prefix, const BvhQueryStats &stats)
+{
+    std::string name(prefix);
+    double queries = std::max(1L, stats.queries);
+    recordScalar((name + "Queries").c_str(), stats.queries);
+    recordScalar((name + "Hits").c_str(), stats.hits);
+    recordScalar((name + "NodesVisitedPerQuery").c_str(), stats.nodesVisited / queries);
+    recordScalar((name + "BoxTestsPerQuery").c_str(), stats.boxTests / queries);
+}
+
+void ObstacleField::finish()
+{
+    recordScalar("obstacles", bvh.getNumObstacles());
+    recordScalar("bvhNodes", bvh.getNumNodes());
+    recordScalar("bvhDepth", bvh.getDepth());
+    recordQueryStats("lineOfSight", lineOfSightStats);
+    recordQueryStats("movement", movementStats);
+    if (observerStats.queries > 0)
+        recordQueryStats("observerLineOfSight", observerStats);
+
+    double queries = std::max(1L, lineOfSightStats.queries);
+    EV << "ObstacleField: " << lineOfSightStats.queries << " line-of-sight queries, "
+       << lineOfSightStats.nodesVisited / queries << " nodes and "
+       << lineOfSightStats.boxTests / queries << " box tests per query; "
+       << movementStats.queries << " movement queries" << endl;
+}
@@ -0,0 +1,55 @@
+//
+// ObstacleField.h
+// 3D box obstacles (buildings, terrain) with BVH-accelerated queries
+//
+
+#ifndef __BAT_ALGORITHM_OBSTACLEFIELD_H_
+#define __BAT_ALGORITHM_OBSTACLEFIELD_H_
+
+#include <omnetpp.h>
+#include <string>
+#include "ObstacleBvh.h"
+
+using namespace omnetpp;
+using namespace inet;
+
+class ObstacleField : public cSimpleModule
+{
+  private:
+    ObstacleBvh bvh;
+
+    // Query counts and traversal costs, per kind of query: link checks,
+    // movement segments (much shorter) and observers (RouteOracle)
+    BvhQueryStats lineOfSightStats;
+    BvhQueryStats movementStats;
+    BvhQueryStats observerStats;
+
+    void recordQueryStats(const char *prefix, const BvhQueryStats &stats);
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    void loadObstacles(const char *fileName);
+
+  public:
+    ObstacleField();
+
+    // True if an obstacle blocks the straight line between two nodes
+    bool isLineOfSightBlocked(const Coord &from, const Coord &to);
+
+    // Same test for observers; counted separately so they do not inflate
+    // the query statistics of the simulated nodes
+    bool isLineOfSightBlockedForObserver(const Coord &from, const Coord &to);
+
+    // Nearest obstacle crossed when moving from -> to (see ObstacleBvh)
+    bool findFirstHit(const Coord &from, const Coord &to, double &t, Coord &normal);
+
+    // Obstacle containing a position, e.g. a UAV placed inside a building
+    bool findContainingObstacle(const Coord &position, ObstacleBox &box) const { return bvh.findContainingBox(position, box); }
+
+    int getNumObstacles() const { return bvh.getNumObstacles(); }
+};
+
+#endif
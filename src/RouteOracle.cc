@@ -0,0 +1,264 @@
+//
+// RouteOracle.cc
+// Implementation of the route optimality observer
+//
+
+#include "RouteOracle.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+Define_Module(RouteOracle);
+
+RouteOracle::RouteOracle()
+{
+    sampleInterval = 0;
+    weightTolerance = 0;
+    numSamples = 0;
+    numEdgeChanges = 0;
+    oracleWallTime = 0;
+    scanWallTime = 0;
+    cellSize = 0;
+    visitStamp = 0;
+    sampleTimer = nullptr;
+}
+
+RouteOracle::~RouteOracle()
+{
+    cancelAndDelete(sampleTimer);
+}
+
+void RouteOracle::initialize()
+{
+    sampleInterval = par("sampleInterval");
+    weightTolerance = par("weightTolerance");
+    if (sampleInterval <= 0)
+        throw cRuntimeError("RouteOracle: sampleInterval must be positive");
+
+    // Index i holds the modules of node i (node IDs are uav[] indices)
+    cModule *network = getParentModule();
+    int numNodes = network->getSubmoduleVectorSize("uav");
+    for (int i = 0; i < numNodes; i++) {
+        cModule *uav = network->getSubmodule("uav", i);
+        mobilities.push_back(check_and_cast<ArbitraryMobility*>(uav->getSubmodule("mobility")));
+        routings.push_back(check_and_cast<BatRouting*>(uav->getSubmodule("batRouting")));
+    }
+    positions.resize(numNodes);
+    paths.reset(numNodes);
+    visited.assign(numNodes, 0);
+    for (BatRouting *routing : routings)
+        cellSize = std::max(cellSize, routing->getCommRange());
+    if (cellSize <= 0)
+        throw cRuntimeError("RouteOracle: commRange must be positive");
+
+    gapSum.assign(numNodes, 0);
+    gapCount.assign(numNodes, 0);
+    routeCount.assign(numNodes, 0);
+    staleCount.assign(numNodes, 0);
+
+    fitnessGapSignal = registerSignal("fitnessGap");
+    staleRouteRatioSignal = registerSignal("staleRouteRatio");
+
+    sampleTimer = new cMessage("oracleSample");
+    scheduleAt(simTime() + sampleInterval, sampleTimer);
+
+    EV << "RouteOracle: Observing " << numNodes << " nodes every " << sampleInterval << "s" << endl;
+}
+
+void RouteOracle::handleMessage(cMessage *msg)
+{
+    if (msg == sampleTimer) {
+        sample();
+        scheduleAt(simTime() + sampleInterval, sampleTimer);
+    }
+    else {
+        delete msg;
+    }
+}
+
+void RouteOracle::sample()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    updateTopology();
+    evaluateRoutes();
+
+    oracleWallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    numSamples++;
+}
+
+void RouteOracle::updateTopology()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int numNodes = positions.size();
+    if (numNodes == 0)
+        return;
+    positions[0] = mobilities[0]->getLastPosition();
+    double minX = positions[0].x, minY = positions[0].y, maxX = minX, maxY = minY;
+    for (int i = 1; i < numNodes; i++) {
+        positions[i] = mobilities[i]->getLastPosition();
+        minX = std::min(minX, positions[i].x);
+        maxX = std::max(maxX, positions[i].x);
+        minY = std::min(minY, positions[i].y);
+        maxY = std::max(maxY, positions[i].y);
+    }
+
+    // Wider cells if the swarm is spread so far that most would be empty
+    double cell = cellSize;
+    while (((maxX - minX) / cell + 1) * ((maxY - minY) / cell + 1) > 4.0 * numNodes + 16)
+        cell *= 2;
+    int width = (int)((maxX - minX) / cell) + 1;
+    int height = (int)((maxY - minY) / cell) + 1;
+
+    cellStart.assign(width * height + 1, 0);
+    nodeCell.resize(numNodes);
+    cellNodes.resize(numNodes);
+    for (int i = 0; i < numNodes; i++) {
+        nodeCell[i] = (int)((positions[i].x - minX) / cell) + width * (int)((positions[i].y - minY) / cell);
+        cellStart[nodeCell[i] + 1]++;
+    }
+    for (int c = 0; c < width * height; c++)
+        cellStart[c + 1] += cellStart[c];
+    candidates.assign(cellStart.begin(), cellStart.end() - 1);   // Fill positions
+    for (int i = 0; i < numNodes; i++)
+        cellNodes[candidates[nodeCell[i]]++] = i;
+
+    // Candidates for u: nodes in the surrounding cells, plus its current
+    // links (which may have moved out of range and must be removed). Each
+    // pair is handled once, from its lower node.
+    for (int u = 0; u < numNodes; u++) {
+        visitStamp++;
+        candidates.clear();
+        int cx = nodeCell[u] % width;
+        int cy = nodeCell[u] / width;
+        for (int y = std::max(0, cy - 1); y <= std::min(height - 1, cy + 1); y++) {
+            for (int x = std::max(0, cx - 1); x <= std::min(width - 1, cx + 1); x++) {
+                int c = x + width * y;
+                for (int k = cellStart[c]; k < cellStart[c + 1]; k++) {
+                    int v = cellNodes[k];
+                    if (v > u) {
+                        visited[v] = visitStamp;
+                        candidates.push_back(v);
+                    }
+                }
+            }
+        }
+        for (int v : paths.getOutEdges(u)) {
+            if (v > u && visited[v] != visitStamp) {
+                visited[v] = visitStamp;
+                candidates.push_back(v);
+            }
+        }
+        for (int v : candidates)
+            updateLink(u, v);
+    }
+    scanWallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    paths.update();
+}
+
+void RouteOracle::updateLink(int u, int v)
+{
+    // Stage the link only if it appeared, broke or changed cost noticeably,
+    // so the update work follows topology changes rather than every movement
+    // Squared range test first: most candidates are out of range
+    Coord delta = positions[u] - positions[v];
+    double range = routings[u]->getCommRange();
+    bool up = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z < range * range
+        && routings[u]->isLinkUpForObserver(positions[u], positions[v]);
+    double distance = up ? delta.length() : 0;
+
+    for (int dir = 0; dir < 2; dir++) {
+        int from = dir == 0 ? u : v;
+        int to = dir == 0 ? v : u;
+        double weight = IncrementalApsp::NO_EDGE;
+        if (up) {
+            BatRouting *routing = routings[from];
+            weight = routing->calculateLinkCost(routing->calculateLinkQuality(distance), to);
+        }
+
+        double current = paths.getWeight(from, to);
+        bool changed = (weight == IncrementalApsp::NO_EDGE) != (current == IncrementalApsp::NO_EDGE)
+            || (up && std::fabs(weight - current) > weightTolerance * current);
+        if (changed) {
+            paths.setWeight(from, to, weight);
+            numEdgeChanges++;
+        }
+    }
+}
+
+double RouteOracle::pathCost(const NodePath &path) const
+{
+    double cost = 0;
+    for (size_t i = 0; i + 1 < path.size(); i++)
+        cost += paths.getWeight(path[i], path[i + 1]);   // NO_EDGE if the link is down
+    return cost;
+}
+
+void RouteOracle::evaluateRoutes()
+{
+    int numNodes = routings.size();
+    for (int s = 0; s < numNodes; s++) {
+        const BatRouting::RouteTable &table = routings[s]->getRouteTable();
+        long routes = 0;
+        long stale = 0;
+        double gaps = 0;
+        long numGaps = 0;
+
+        for (const auto &entry : table) {
+            int dest = entry.first;
+            const BatRouting::RouteList &list = entry.second;
+            for (size_t r = 0; r < list.size(); r++) {
+                double cost = pathCost(list[r].path);
+                routes++;
+                if (std::isinf(cost)) {
+                    stale++;
+                    continue;
+                }
+
+                // The first entry is what selectBestRoute() would use
+                double optimal = paths.getDistance(s, dest);
+                if (r == 0 && optimal > 0 && !std::isinf(optimal)) {
+                    gaps += cost / optimal - 1;
+                    numGaps++;
+                }
+            }
+        }
+
+        if (routes > 0) {
+            emit(staleRouteRatioSignal, (double)stale / routes);
+            routeCount[s] += routes;
+            staleCount[s] += stale;
+        }
+        if (numGaps > 0) {
+            emit(fitnessGapSignal, gaps / numGaps);
+            gapSum[s] += gaps / numGaps;
+            gapCount[s]++;
+        }
+    }
+}
+
+void RouteOracle::finish()
+{
+    // Per-node results are recorded on the node's routing module, next to
+    // its own statistics
+    int numNodes = routings.size();
+    for (int i = 0; i < numNodes; i++) {
+        if (gapCount[i] > 0)
+            routings[i]->recordScalar("oracleFitnessGap", gapSum[i] / gapCount[i]);
+        if (routeCount[i] > 0)
+            routings[i]->recordScalar("oracleStaleRouteRatio", (double)staleCount[i] / routeCount[i]);
+    }
+
+    recordScalar("samples", numSamples);
+    recordScalar("edgeChanges", numEdgeChanges);
+    recordScalar("sourcesRepaired", paths.getNumSourcesRepaired());
+    recordScalar("nodesInvalidated", paths.getNumNodesInvalidated());
+    recordScalar("fullRecomputations", paths.getNumFullRuns());
+    recordScalar("oracleWallTime", oracleWallTime);
+    recordScalar("oracleScanWallTime", scanWallTime);
+
+    EV << "RouteOracle: " << numSamples << " samples, " << numEdgeChanges << " edge changes, "
+       << paths.getNumSourcesRepaired() << " source trees repaired, " << oracleWallTime << "s wall time" << endl;
+}
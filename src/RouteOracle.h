@@ -0,0 +1,77 @@
+//
+// RouteOracle.h
+// Compares BatRouting route tables with shortest paths over the live topology
+//
+
+#ifndef __BAT_ALGORITHM_ROUTEORACLE_H_
+#define __BAT_ALGORITHM_ROUTEORACLE_H_
+
+#include <omnetpp.h>
+#include <vector>
+#include "ArbitraryMobility.h"
+#include "BatRouting.h"
+#include "IncrementalApsp.h"
+
+using namespace omnetpp;
+
+class RouteOracle : public cSimpleModule
+{
+  private:
+    // Parameters
+    double sampleInterval;
+    double weightTolerance;
+
+    // Cached UAV submodules, indexed by node ID
+    std::vector<ArbitraryMobility*> mobilities;
+    std::vector<BatRouting*> routings;
+    std::vector<Coord> positions;
+
+    // Shortest paths over the link graph
+    IncrementalApsp paths;
+
+    // Uniform XY grid with cells at least the largest commRange wide, so
+    // only nodes in the 3x3 surrounding cells are tested for a link (the XY
+    // distance never exceeds the 3D one). Rebuilt each sample by counting
+    // sort: nodes of cell c are cellNodes[cellStart[c], cellStart[c+1]).
+    double cellSize;
+    std::vector<int> nodeCell;
+    std::vector<int> cellStart;
+    std::vector<int> cellNodes;
+    std::vector<int> candidates;
+    std::vector<int> visited;       // Sample-local stamp per node
+    int visitStamp;
+
+    // Per-node accumulators for the end-of-run scalars
+    std::vector<double> gapSum;
+    std::vector<long> gapCount;
+    std::vector<long> routeCount;
+    std::vector<long> staleCount;
+
+    // Statistics
+    simsignal_t fitnessGapSignal;
+    simsignal_t staleRouteRatioSignal;
+    long numSamples;
+    long numEdgeChanges;
+    double oracleWallTime;
+    double scanWallTime;            // Part of oracleWallTime spent finding links
+
+    // Messages
+    cMessage *sampleTimer;
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    void sample();
+    void updateTopology();
+    void updateLink(int u, int v);
+    void evaluateRoutes();
+    double pathCost(const NodePath &path) const;
+
+  public:
+    RouteOracle();
+    virtual ~RouteOracle();
+};
+
+#endif
@@ -0,0 +1,109 @@
+//
+// RoutingEpochCoordinator.cc
+// Implementation of synchronized routing epochs
+//
+
+#include "RoutingEpochCoordinator.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+Define_Module(RoutingEpochCoordinator);
+
+RoutingEpochCoordinator::RoutingEpochCoordinator()
+{
+    epochInterval = 0;
+    pool = nullptr;
+    numEpochs = 0;
+    epochWallTime = 0;
+    epochTimer = nullptr;
+}
+
+RoutingEpochCoordinator::~RoutingEpochCoordinator()
+{
+    cancelAndDelete(epochTimer);
+    delete pool;
+}
+
+void RoutingEpochCoordinator::initialize()
+{
+    epochInterval = par("epochInterval");
+    if (epochInterval <= 0)
+        throw cRuntimeError("RoutingEpochCoordinator: epochInterval must be positive");
+
+    cModule *network = getParentModule();
+    int numNodes = network->getSubmoduleVectorSize("uav");
+    for (int i = 0; i < numNodes; i++) {
+        cModule *uav = network->getSubmodule("uav", i);
+        BatRouting *routing = check_and_cast<BatRouting*>(uav->getSubmodule("batRouting"));
+        if (!routing->usesSynchronizedEpochs())
+            throw cRuntimeError("RoutingEpochCoordinator: %s must set synchronizedEpochs = true, "
+                                "otherwise its routes would be updated twice", routing->getFullPath().c_str());
+        routings.push_back(routing);
+    }
+
+    int numThreads = par("numThreads");
+    if (numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    pool = new ThreadPool(numThreads);
+
+    double firstEpoch = par("firstEpoch");
+    epochTimer = new cMessage("routingEpoch");
+    scheduleAt(firstEpoch, epochTimer);
+
+    EV << "RoutingEpochCoordinator: " << numNodes << " nodes, epoch every " << epochInterval
+       << "s on " << pool->getNumThreads() << " threads" << endl;
+}
+
+void RoutingEpochCoordinator::handleMessage(cMessage *msg)
+{
+    if (msg == epochTimer) {
+        runEpoch();
+        scheduleAt(simTime() + epochInterval, epochTimer);
+    }
+    else {
+        delete msg;
+    }
+}
+
+void RoutingEpochCoordinator::runEpoch()
+{
+    simtime_t now = simTime();
+    int numNodes = routings.size();
+    auto start = std::chrono::steady_clock::now();
+
+    if (pool->getNumThreads() == 1) {
+        // Serial reference: the same order as per-node timers firing together
+        for (BatRouting *routing : routings) {
+            routing->beginRoutingEpoch();
+            routing->maintainRouteTable(now);
+            routing->endRoutingEpoch();
+        }
+    }
+    else {
+        // Discovery draws random numbers and sends messages: simulation thread only
+        for (BatRouting *routing : routings)
+            routing->beginRoutingEpoch();
+
+        pool->parallelFor(numNodes, [this, now](int i) {
+            routings[i]->maintainRouteTable(now);
+        });
+
+        for (BatRouting *routing : routings)
+            routing->endRoutingEpoch();
+    }
+
+    epochWallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    numEpochs++;
+}
+
+void RoutingEpochCoordinator::finish()
+{
+    recordScalar("epochs", numEpochs);
+    recordScalar("threads", pool->getNumThreads());
+    recordScalar("steals", pool->getNumSteals());
+    recordScalar("epochWallTime", epochWallTime);
+
+    EV << "RoutingEpochCoordinator: " << numEpochs << " epochs, "
+       << epochWallTime << "s wall time in epochs" << endl;
+}
@@ -0,0 +1,46 @@
+//
+// RoutingEpochCoordinator.h
+// Runs all nodes' route updates in synchronized epochs on a thread pool
+//
+
+#ifndef __BAT_ALGORITHM_ROUTINGEPOCHCOORDINATOR_H_
+#define __BAT_ALGORITHM_ROUTINGEPOCHCOORDINATOR_H_
+
+#include <omnetpp.h>
+#include <vector>
+#include "BatRouting.h"
+#include "ThreadPool.h"
+
+using namespace omnetpp;
+
+class RoutingEpochCoordinator : public cSimpleModule
+{
+  private:
+    // Parameters
+    double epochInterval;
+
+    // Routing modules of all UAVs, indexed by node ID
+    std::vector<BatRouting*> routings;
+
+    ThreadPool *pool;
+
+    // Statistics
+    long numEpochs;
+    double epochWallTime;         // Wall-clock seconds spent running epochs
+
+    // Messages
+    cMessage *epochTimer;
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    void runEpoch();
+
+  public:
+    RoutingEpochCoordinator();
+    virtual ~RoutingEpochCoordinator();
+};
+
+#endif
@@ -0,0 +1,220 @@
+//
+// StreamingStatsRecorder.cc
+// Implementation of the binnedSummary result recorder
+//
+
+#include "StreamingStatsRecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Register_ResultRecorder("binnedSummary", BinnedSummaryRecorder);
+
+Register_PerObjectConfigOptionU(CFGID_BINNED_SUMMARY_INTERVAL, "binned-summary-interval", KIND_STATISTIC, "s", "1s",
+    "Bin width of the binnedSummary result recorder. Example: **.packetRouted.binned-summary-interval = 10s");
+
+//
+// P2Quantile
+//
+
+P2Quantile::P2Quantile(double p) : p(p), count(0)
+{
+    for (int i = 0; i < 5; i++) {
+        heights[i] = 0;
+        positions[i] = i + 1;
+    }
+    desired[0] = 1;
+    desired[1] = 1 + 2 * p;
+    desired[2] = 1 + 4 * p;
+    desired[3] = 3 + 2 * p;
+    desired[4] = 5;
+    increments[0] = 0;
+    increments[1] = p / 2;
+    increments[2] = p;
+    increments[3] = (1 + p) / 2;
+    increments[4] = 1;
+}
+
+double P2Quantile::parabolic(int i, int d) const
+{
+    const double *q = heights;
+    const double *n = positions;
+    return q[i] + d / (n[i + 1] - n[i - 1])
+        * ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i])
+         + (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+double P2Quantile::linear(int i, int d) const
+{
+    return heights[i] + d * (heights[i + d] - heights[i]) / (positions[i + d] - positions[i]);
+}
+
+void P2Quantile::add(double x)
+{
+    // The first five observations initialize the markers
+    if (count < 5) {
+        heights[count++] = x;
+        if (count == 5)
+            std::sort(heights, heights + 5);
+        return;
+    }
+    count++;
+
+    // Find the cell containing x, extending the extremes if needed
+    int k;
+    if (x < heights[0]) {
+        heights[0] = x;
+        k = 0;
+    }
+    else if (x >= heights[4]) {
+        heights[4] = std::max(heights[4], x);
+        k = 3;
+    }
+    else {
+        k = 0;
+        while (x >= heights[k + 1])
+            k++;
+    }
+
+    for (int i = k + 1; i < 5; i++)
+        positions[i]++;
+    for (int i = 0; i < 5; i++)
+        desired[i] += increments[i];
+
+    // Move the middle markers toward their desired positions
+    for (int i = 1; i <= 3; i++) {
+        double delta = desired[i] - positions[i];
+        if ((delta >= 1 && positions[i + 1] - positions[i] > 1)
+            || (delta <= -1 && positions[i - 1] - positions[i] < -1)) {
+            int d = delta > 0 ? 1 : -1;
+            double candidate = parabolic(i, d);
+            if (heights[i - 1] < candidate && candidate < heights[i + 1])
+                heights[i] = candidate;
+            else
+                heights[i] = linear(i, d);
+            positions[i] += d;
+        }
+    }
+}
+
+double P2Quantile::get() const
+{
+    if (count == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    if (count < 5) {
+        // Too few samples for the markers: exact nearest-rank quantile
+        double sorted[5];
+        std::copy(heights, heights + count, sorted);
+        std::sort(sorted, sorted + count);
+        int rank = std::min<long>(count - 1, (long)std::floor(p * count));
+        return sorted[rank];
+    }
+    return heights[2];
+}
+
+//
+// BinnedSummaryRecorder
+//
+
+BinnedSummaryRecorder::BinnedSummaryRecorder()
+    : rateP50(0.5), rateP90(0.9), rateP99(0.99)
+{
+    binWidth = 1;
+    binCount = 0;
+    totalCount = 0;
+    totalSum = 0;
+    minValue = std::numeric_limits<double>::infinity();
+    maxValue = -std::numeric_limits<double>::infinity();
+    numBins = 0;
+    maxRate = 0;
+    binnedVector = nullptr;
+}
+
+std::string BinnedSummaryRecorder::resultName(const char *suffix) const
+{
+    return std::string(getStatisticName()) + ":" + suffix;
+}
+
+void BinnedSummaryRecorder::init(Context *ctx)
+{
+    cNumericResultRecorder::init(ctx);
+
+    std::string objectPath = getComponent()->getFullPath() + "." + getStatisticName();
+    binWidth = getEnvir()->getConfig()->getAsDouble(objectPath.c_str(), CFGID_BINNED_SUMMARY_INTERVAL, 1.0);
+    if (binWidth <= 0)
+        throw cRuntimeError("binnedSummary: binned-summary-interval must be positive for %s", objectPath.c_str());
+
+    startTime = simTime();
+    binStart = startTime;
+    rateHistogram.setName(resultName("binRate").c_str());
+
+    // One point per bin instead of one per event
+    binnedVector = getEnvir()->registerOutputVector(getComponent()->getFullPath().c_str(), resultName("binned").c_str());
+    if (binnedVector)
+        getEnvir()->setVectorAttribute(binnedVector, "interpolationmode", "sample-hold");
+}
+
+void BinnedSummaryRecorder::closeBin(simtime_t end)
+{
+    double duration = (end - binStart).dbl();
+    if (duration <= 0) return;
+
+    double rate = binCount / duration;
+    rateP50.add(rate);
+    rateP90.add(rate);
+    rateP99.add(rate);
+    rateHistogram.collect(rate);
+    maxRate = std::max(maxRate, rate);
+    numBins++;
+
+    if (binnedVector)
+        getEnvir()->recordInOutputVector(binnedVector, end, binCount);
+
+    binStart = end;
+    binCount = 0;
+}
+
+void BinnedSummaryRecorder::closeBinsUntil(simtime_t t)
+{
+    // Idle gaps produce empty bins, which count as zero-rate intervals in
+    // the quantiles and histogram and are written as 0 to the vector
+    while (t >= binStart + binWidth)
+        closeBin(binStart + binWidth);
+}
+
+void BinnedSummaryRecorder::collect(simtime_t_cref t, double value, cObject *details)
+{
+    closeBinsUntil(t);
+
+    binCount++;
+    totalCount++;
+    totalSum += value;
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+}
+
+void BinnedSummaryRecorder::finish(cResultFilter *prev)
+{
+    simtime_t now = simTime();
+    closeBinsUntil(now);
+    closeBin(now);   // Final partial bin, rate over its actual length
+
+    cComponent *component = getComponent();
+    cEnvir *envir = getEnvir();
+    envir->recordScalar(component, resultName("total").c_str(), totalCount);
+    envir->recordScalar(component, resultName("sum").c_str(), totalSum);
+    if (totalCount > 0) {
+        envir->recordScalar(component, resultName("min").c_str(), minValue);
+        envir->recordScalar(component, resultName("max").c_str(), maxValue);
+    }
+    envir->recordScalar(component, resultName("bins").c_str(), numBins);
+    if (numBins > 0 && now > startTime) {
+        envir->recordScalar(component, resultName("rateMean").c_str(), totalCount / (now - startTime).dbl());
+        envir->recordScalar(component, resultName("rateP50").c_str(), rateP50.get());
+        envir->recordScalar(component, resultName("rateP90").c_str(), rateP90.get());
+        envir->recordScalar(component, resultName("rateP99").c_str(), rateP99.get());
+        envir->recordScalar(component, resultName("rateMax").c_str(), maxRate);
+        envir->recordStatistic(component, resultName("binRate").c_str(), &rateHistogram);
+    }
+}
@@ -0,0 +1,94 @@
+//
+// StreamingStatsRecorder.h
+// In-memory time-binned summary recorder replacing per-event vectors
+//
+
+#ifndef __BAT_ALGORITHM_STREAMINGSTATSRECORDER_H_
+#define __BAT_ALGORITHM_STREAMINGSTATSRECORDER_H_
+
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+//
+// Streaming quantile estimate using the P-square algorithm (Jain & Chlamtac,
+// 1985): five markers, O(1) memory and time per observation.
+//
+class P2Quantile
+{
+  private:
+    double p;
+    long count;
+    double heights[5];      // Marker heights
+    double positions[5];    // Actual marker positions (1-based)
+    double desired[5];      // Desired marker positions
+    double increments[5];   // Desired position increments
+
+    double parabolic(int i, int d) const;
+    double linear(int i, int d) const;
+
+  public:
+    explicit P2Quantile(double p = 0.5);
+
+    void add(double x);
+    double get() const;
+    long getCount() const { return count; }
+};
+
+//
+// Result recorder "binnedSummary". Instead of writing every emitted value it
+// keeps, in memory:
+//  - the number of values in fixed time bins (binned-summary-interval)
+//  - a histogram and P-square p50/p90/p99 of the per-bin event rates
+//  - total count, sum, min, max of the values
+//
+// Every interval of the run is a bin: intervals without values are closed
+// as zero-rate bins, so the rate statistics are not biased toward busy
+// periods. Each closed bin is written as one point of the "<stat>:binned" vector
+// (one point per interval instead of one per event), and the summary is
+// recorded as scalars and a histogram at finish().
+//
+// Bins are only closed when a value arrives after their end or at finish():
+// the recorder schedules no events. Trailing bins of a quiet signal appear
+// at finish(), and a run that ends in an error (no finish()) loses the bins
+// since the last value and the summary.
+//
+// Attach it to a compound module's @statistic with source=<signal> to get a
+// swarm-wide summary: signals propagate up from all submodules.
+//
+class BinnedSummaryRecorder : public cNumericResultRecorder
+{
+  private:
+    double binWidth;
+    simtime_t startTime;
+    simtime_t binStart;
+    long binCount;
+
+    long totalCount;
+    double totalSum;
+    double minValue;
+    double maxValue;
+
+    long numBins;
+    double maxRate;
+    P2Quantile rateP50;
+    P2Quantile rateP90;
+    P2Quantile rateP99;
+    cHistogram rateHistogram;
+
+    void *binnedVector;
+
+    void closeBin(simtime_t end);
+    void closeBinsUntil(simtime_t t);
+    std::string resultName(const char *suffix) const;
+
+  protected:
+    virtual void init(Context *ctx) override;
+    virtual void collect(simtime_t_cref t, double value, cObject *details) override;
+    virtual void finish(cResultFilter *prev) override;
+
+  public:
+    BinnedSummaryRecorder();
+};
+
+#endif
@@ -0,0 +1,182 @@
+//
+// SwarmTelemetry.cc
+// Implementation of the shared-memory swarm telemetry exporter
+//
+
+#include "SwarmTelemetry.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace battelemetry;
+
+Define_Module(SwarmTelemetry);
+
+SwarmTelemetry::SwarmTelemetry()
+{
+    shmFd = -1;
+    segment = nullptr;
+    segmentBytes = 0;
+    maxNodes = 0;
+    numSnapshots = 0;
+    publishTimer = nullptr;
+}
+
+SwarmTelemetry::~SwarmTelemetry()
+{
+    cancelAndDelete(publishTimer);
+    closeSegment();
+}
+
+void SwarmTelemetry::initialize()
+{
+    segmentName = par("segmentName").stdstringValue();
+    updateInterval = par("updateInterval");
+    unlinkOnFinish = par("unlinkOnFinish");
+
+    if (updateInterval <= 0)
+        throw cRuntimeError("SwarmTelemetry: updateInterval must be positive");
+
+    // Cache UAV submodules once; the swarm size is fixed for the whole run
+    cModule *network = getParentModule();
+    int numNodes = network->getSubmoduleVectorSize("uav");
+    for (int i = 0; i < numNodes; i++) {
+        cModule *uav = network->getSubmodule("uav", i);
+        mobilities.push_back(check_and_cast<ArbitraryMobility*>(uav->getSubmodule("mobility")));
+        routings.push_back(check_and_cast<BatRouting*>(uav->getSubmodule("batRouting")));
+    }
+    maxNodes = numNodes;
+
+    openSegment();
+
+    publishTimer = new cMessage("telemetryPublish");
+    scheduleAt(simTime() + updateInterval, publishTimer);
+
+    EV << "SwarmTelemetry: Publishing " << maxNodes << " nodes to shm segment "
+       << segmentName << " every " << updateInterval << "s" << endl;
+}
+
+void SwarmTelemetry::handleMessage(cMessage *msg)
+{
+    if (msg == publishTimer) {
+        publishSnapshot();
+        scheduleAt(simTime() + updateInterval, publishTimer);
+    }
+    else {
+        delete msg;
+    }
+}
+
+void SwarmTelemetry::openSegment()
+{
+    segmentBytes = segmentSize(maxNodes);
+
+    // O_EXCL: never take over a segment of another (concurrent) run
+    shmFd = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (shmFd < 0 && errno == EEXIST)
+        throw cRuntimeError("SwarmTelemetry: shm segment %s already exists. Another run is using it, or a crashed "
+                            "run left it behind (remove /dev/shm%s). Give concurrent runs distinct segmentName values, "
+                            "e.g. \"/bat-telemetry-${runnumber}\" in omnetpp.ini", segmentName.c_str(), segmentName.c_str());
+    if (shmFd < 0)
+        throw cRuntimeError("SwarmTelemetry: shm_open(%s) failed: %s", segmentName.c_str(), strerror(errno));
+
+    if (ftruncate(shmFd, segmentBytes) != 0)
+        throw cRuntimeError("SwarmTelemetry: ftruncate(%s) failed: %s", segmentName.c_str(), strerror(errno));
+
+    segment = mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    if (segment == MAP_FAILED) {
+        segment = nullptr;
+        throw cRuntimeError("SwarmTelemetry: mmap(%s) failed: %s", segmentName.c_str(), strerror(errno));
+    }
+
+    // Publish the header with the magic written last, so readers never see
+    // a half-initialized segment
+    memset(segment, 0, segmentBytes);
+    SegmentHeader *hdr = static_cast<SegmentHeader*>(segment);
+    hdr->version = TELEMETRY_VERSION;
+    hdr->maxNodes = maxNodes;
+    hdr->bufferStride = bufferStride(maxNodes);
+    hdr->activeBuffer.store(0, std::memory_order_relaxed);
+    hdr->publishCount.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < TELEMETRY_NUM_BUFFERS; i++)
+        hdr->sequence[i].store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr->magic = TELEMETRY_MAGIC;
+}
+
+void SwarmTelemetry::closeSegment()
+{
+    if (segment) {
+        munmap(segment, segmentBytes);
+        segment = nullptr;
+    }
+    if (shmFd >= 0) {
+        close(shmFd);
+        shmFd = -1;
+        if (unlinkOnFinish)
+            shm_unlink(segmentName.c_str());
+    }
+}
+
+void SwarmTelemetry::publishSnapshot()
+{
+    if (!segment) return;
+
+    SegmentHeader *hdr = static_cast<SegmentHeader*>(segment);
+
+    // Write into the buffer readers are not currently directed to
+    int target = 1 - (int)hdr->activeBuffer.load(std::memory_order_relaxed);
+    std::atomic<uint64_t> &seq = hdr->sequence[target];
+
+    uint64_t start = seq.load(std::memory_order_relaxed) + 1;   // Odd: write in progress
+    seq.store(start, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SnapshotHeader *snapshot = snapshotAt(segment, target);
+    NodeRecord *nodes = nodesOf(snapshot);
+    snapshot->simTime = simTime().dbl();
+    snapshot->eventNumber = getSimulation()->getEventNumber();
+    snapshot->numNodes = maxNodes;
+
+    for (uint32_t i = 0; i < maxNodes; i++) {
+        // Observer access, see ArbitraryMobility::getLastPosition()
+        const Coord &pos = mobilities[i]->getLastPosition();
+        const Coord &vel = mobilities[i]->getLastVelocity();
+        const BatRouting *routing = routings[i];
+
+        NodeRecord &rec = nodes[i];
+        rec.nodeId = i;
+        rec.routeDestinations = routing->getRouteTableSize();
+        rec.routeEntries = routing->getRouteEntryCount();
+        rec.reserved = 0;
+        rec.x = pos.x;
+        rec.y = pos.y;
+        rec.z = pos.z;
+        rec.vx = vel.x;
+        rec.vy = vel.y;
+        rec.vz = vel.z;
+        rec.routeRequestsSent = routing->getRouteRequestsSent();
+        rec.routesDiscovered = routing->getRoutesDiscovered();
+        rec.packetsRouted = routing->getPacketsRouted();
+    }
+
+    seq.store(start + 1, std::memory_order_release);             // Even: stable
+    hdr->activeBuffer.store(target, std::memory_order_release);
+    hdr->publishCount.fetch_add(1, std::memory_order_release);
+
+    numSnapshots++;
+}
+
+void SwarmTelemetry::finish()
+{
+    // Publish the final state so a reader attached at the end sees it
+    publishSnapshot();
+
+    recordScalar("telemetrySnapshots", numSnapshots);
+
+    EV << "SwarmTelemetry: Published " << numSnapshots << " snapshots to "
+       << segmentName << endl;
+}
@@ -0,0 +1,56 @@
+//
+// SwarmTelemetry.h
+// Publishes live swarm state to POSIX shared memory for headless runs
+//
+
+#ifndef __BAT_ALGORITHM_SWARMTELEMETRY_H_
+#define __BAT_ALGORITHM_SWARMTELEMETRY_H_
+
+#include <omnetpp.h>
+#include <string>
+#include <vector>
+#include "TelemetryLayout.h"
+#include "ArbitraryMobility.h"
+#include "BatRouting.h"
+
+using namespace omnetpp;
+
+class SwarmTelemetry : public cSimpleModule
+{
+  private:
+    // Parameters
+    std::string segmentName;
+    double updateInterval;
+    bool unlinkOnFinish;
+
+    // Shared memory segment
+    int shmFd;
+    void *segment;
+    size_t segmentBytes;
+    uint32_t maxNodes;
+
+    // Cached UAV submodules, indexed by node ID
+    std::vector<ArbitraryMobility*> mobilities;
+    std::vector<BatRouting*> routings;
+
+    // Statistics
+    long numSnapshots;
+
+    // Messages
+    cMessage *publishTimer;
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    void openSegment();
+    void closeSegment();
+    void publishSnapshot();
+
+  public:
+    SwarmTelemetry();
+    virtual ~SwarmTelemetry();
+};
+
+#endif
@@ -0,0 +1,100 @@
+//
+// TelemetryLayout.h
+// Shared-memory layout of the live swarm telemetry segment
+//
+// This header is shared between the SwarmTelemetry module (writer) and
+// tools/telemetry_reader (reader), so it must not depend on OMNeT++ or INET.
+//
+// The segment holds two snapshot buffers. Each buffer is guarded by its own
+// seqlock counter (odd = being written, even = stable). The writer always
+// fills the buffer that is NOT active and flips activeBuffer when done, so a
+// reader normally copies a buffer that nobody is writing to and only retries
+// if it was lapped by two consecutive publications.
+//
+
+#ifndef __BAT_ALGORITHM_TELEMETRYLAYOUT_H_
+#define __BAT_ALGORITHM_TELEMETRYLAYOUT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace battelemetry {
+
+const uint32_t TELEMETRY_MAGIC = 0x54544142;   // "BATT"
+const uint32_t TELEMETRY_VERSION = 1;
+const int TELEMETRY_NUM_BUFFERS = 2;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "telemetry seqlock requires lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "telemetry seqlock requires lock-free 32-bit atomics");
+
+// Per-UAV state published in every snapshot
+struct NodeRecord {
+    int32_t nodeId;
+    int32_t routeDestinations;    // Destinations present in routeTable
+    int32_t routeEntries;         // Total routes over all destinations
+    int32_t reserved;
+    double x, y, z;               // Position (m)
+    double vx, vy, vz;            // Velocity (m/s)
+    uint64_t routeRequestsSent;   // RREQ copies transmitted
+    uint64_t routesDiscovered;    // RREQs that reached this node as destination
+    uint64_t packetsRouted;       // Data packets handled by routeDataPacket
+};
+
+// Header of one snapshot buffer, followed by maxNodes NodeRecords
+struct SnapshotHeader {
+    double simTime;
+    uint64_t eventNumber;
+    uint32_t numNodes;
+    uint32_t reserved;
+};
+
+// Header at offset 0 of the segment
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t maxNodes;
+    uint32_t bufferStride;                                  // Bytes per snapshot buffer
+    std::atomic<uint32_t> activeBuffer;                     // Last completely written buffer
+    uint32_t reserved;
+    std::atomic<uint64_t> publishCount;                     // Number of published snapshots
+    std::atomic<uint64_t> sequence[TELEMETRY_NUM_BUFFERS];  // Seqlock counter per buffer
+};
+
+inline size_t alignUp(size_t n, size_t alignment)
+{
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+inline size_t bufferStride(uint32_t maxNodes)
+{
+    return alignUp(sizeof(SnapshotHeader) + maxNodes * sizeof(NodeRecord), 64);
+}
+
+inline size_t buffersOffset()
+{
+    return alignUp(sizeof(SegmentHeader), 64);
+}
+
+inline size_t segmentSize(uint32_t maxNodes)
+{
+    return buffersOffset() + TELEMETRY_NUM_BUFFERS * bufferStride(maxNodes);
+}
+
+inline SnapshotHeader *snapshotAt(void *segment, int index)
+{
+    SegmentHeader *hdr = static_cast<SegmentHeader*>(segment);
+    char *base = static_cast<char*>(segment) + buffersOffset();
+    return reinterpret_cast<SnapshotHeader*>(base + index * (size_t)hdr->bufferStride);
+}
+
+inline NodeRecord *nodesOf(SnapshotHeader *snapshot)
+{
+    return reinterpret_cast<NodeRecord*>(snapshot + 1);
+}
+
+} // namespace battelemetry
+
+#endif
@@ -0,0 +1,139 @@
+//
+// ThreadPool.cc
+// Implementation of the work-stealing thread pool
+//
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    generation = 0;
+    stopping = false;
+    task = nullptr;
+    pendingChunks = 0;
+    numSteals = 0;
+
+    numThreads = std::max(1, numThreads);
+    for (int i = 0; i < numThreads; i++)
+        queues.emplace_back(new WorkQueue());
+    for (int i = 1; i < numThreads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(int n, const std::function<void(int)> &body)
+{
+    if (n <= 0) return;
+
+    if (workers.empty()) {
+        for (int i = 0; i < n; i++)
+            body(i);
+        return;
+    }
+
+    // Several chunks per thread so stealing can even out unequal tasks
+    int numQueues = queues.size();
+    int grain = std::max(1, n / (numQueues * 4));
+    int numChunks = (n + grain - 1) / grain;
+
+    // Publish the task before any chunk becomes visible: a worker still
+    // draining the previous loop may pick up a new chunk right away
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &body;
+        failure = nullptr;
+        pendingChunks = numChunks;
+        generation++;
+    }
+
+    for (int c = 0; c < numChunks; c++) {
+        WorkQueue &queue = *queues[c % numQueues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.push_back(Chunk{c * grain, std::min(n, (c + 1) * grain)});
+    }
+    workAvailable.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this]() { return pendingChunks.load() == 0; });
+    task = nullptr;
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+void ThreadPool::workerLoop(int self)
+{
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        drain(self);
+    }
+}
+
+void ThreadPool::drain(int self)
+{
+    Chunk chunk;
+    while (popOwn(self, chunk) || steal(self, chunk)) {
+        runChunk(chunk);
+        if (pendingChunks.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            workDone.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::popOwn(int self, Chunk &chunk)
+{
+    WorkQueue &queue = *queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.chunks.empty()) return false;
+    chunk = queue.chunks.back();
+    queue.chunks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int self, Chunk &chunk)
+{
+    int numQueues = queues.size();
+    for (int i = 1; i < numQueues; i++) {
+        WorkQueue &victim = *queues[(self + i) % numQueues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.front();
+            victim.chunks.pop_front();
+            numSteals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runChunk(const Chunk &chunk)
+{
+    try {
+        for (int i = chunk.begin; i < chunk.end; i++)
+            (*task)(i);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failure)
+            failure = std::current_exception();
+    }
+}
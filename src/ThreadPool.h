@@ -0,0 +1,76 @@
+//
+// ThreadPool.h
+// Small work-stealing thread pool for data-parallel loops
+//
+// No OMNeT++ dependency. Tasks must not call simulation APIs (send, emit,
+// EV, RNG): only the simulation thread may do that.
+//
+
+#ifndef __BAT_ALGORITHM_THREADPOOL_H_
+#define __BAT_ALGORITHM_THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+  private:
+    // Half-open index range [begin, end)
+    struct Chunk {
+        int begin;
+        int end;
+    };
+
+    // Per-thread deque: the owner pops from the back, thieves take the front
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;   // queues[0] belongs to the caller
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    uint64_t generation;
+    bool stopping;
+
+    const std::function<void(int)> *task;
+    std::atomic<int> pendingChunks;
+    std::exception_ptr failure;
+
+    // Statistics
+    std::atomic<long> numSteals;
+
+    void workerLoop(int self);
+    bool popOwn(int self, Chunk &chunk);
+    bool steal(int self, Chunk &chunk);
+    void drain(int self);
+    void runChunk(const Chunk &chunk);
+
+  public:
+    // numThreads counts the calling thread; 1 runs everything inline
+    explicit ThreadPool(int numThreads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs body(i) for every i in [0, n) and returns when all have finished.
+    // The calling thread takes part. The first exception thrown by a task is
+    // rethrown here after the loop completes.
+    void parallelFor(int n, const std::function<void(int)> &body);
+
+    int getNumThreads() const { return queues.size(); }
+    long getNumSteals() const { return numSteals.load(); }
+};
+
+#endif
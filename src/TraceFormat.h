@@ -0,0 +1,66 @@
+//
+// TraceFormat.h
+// Binary layout of mobility trace files (see tools/trace_convert)
+//
+// This header is shared between ArbitraryMobility's trace replay mode and
+// tools/trace_convert, so it must not depend on OMNeT++ or INET.
+//
+// File layout (little-endian, all offsets 8-byte aligned):
+//
+//   TraceHeader
+//   TraceTrack[numTracks]        one per UAV index, 0..numTracks-1
+//   TraceSample[numSamples]      grouped by track, sorted by time in each track
+//
+
+#ifndef __BAT_ALGORITHM_TRACEFORMAT_H_
+#define __BAT_ALGORITHM_TRACEFORMAT_H_
+
+#include <cstdint>
+
+namespace battrace {
+
+const char TRACE_MAGIC[8] = {'B', 'A', 'T', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numTracks;
+    uint64_t numSamples;
+    double startTime;         // Earliest timestamp in the file (s)
+    double endTime;           // Latest timestamp in the file (s)
+};
+
+struct TraceTrack {
+    uint64_t firstSample;     // Index into the sample array
+    uint32_t numSamples;      // 0 if the UAV has no recorded waypoints
+    uint32_t reserved;
+};
+
+struct TraceSample {
+    double t;                 // Timestamp (s)
+    double x, y, z;           // Position (m)
+};
+
+static_assert(sizeof(TraceHeader) == 40, "unexpected TraceHeader padding");
+static_assert(sizeof(TraceTrack) == 16, "unexpected TraceTrack padding");
+static_assert(sizeof(TraceSample) == 32, "unexpected TraceSample padding");
+
+inline uint64_t tracksOffset()
+{
+    return sizeof(TraceHeader);
+}
+
+inline uint64_t samplesOffset(uint32_t numTracks)
+{
+    return tracksOffset() + numTracks * sizeof(TraceTrack);
+}
+
+inline uint64_t traceFileSize(uint32_t numTracks, uint64_t numSamples)
+{
+    return samplesOffset(numTracks) + numSamples * sizeof(TraceSample);
+}
+
+} // namespace battrace
+
+#endif
@@ -0,0 +1,131 @@
+//
+// apsptest.cc
+// Randomized check of IncrementalApsp against Floyd-Warshall
+//
+// Usage: apsptest [rounds]
+//
+// Two scenarios: random directed graphs with batches of insertions, removals
+// and weight changes, and UAVs moving in a square with unit-disk links (the
+// RouteOracle case). After every update() all distances must match a
+// Floyd-Warshall run over the same weights.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "IncrementalApsp.h"
+
+static long checkAgainstFloydWarshall(const IncrementalApsp &paths)
+{
+    int n = paths.getNumNodes();
+    std::vector<double> dist(n * n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            dist[i * n + j] = i == j ? 0 : paths.getWeight(i, j);
+    for (int k = 0; k < n; k++)
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                dist[i * n + j] = std::min(dist[i * n + j], dist[i * n + k] + dist[k * n + j]);
+
+    long mismatches = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            double expected = dist[i * n + j];
+            double actual = paths.getDistance(i, j);
+            if (std::isinf(expected) != std::isinf(actual)
+                || (!std::isinf(expected) && std::fabs(expected - actual) > 1e-9 * std::max(1.0, expected))) {
+                if (mismatches == 0)
+                    printf("  first mismatch: %d -> %d expected %g, got %g\n", i, j, expected, actual);
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+static long randomGraphs(int rounds, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    const int n = 60;
+    IncrementalApsp paths;
+    paths.reset(n);
+
+    long mismatches = 0;
+    for (int round = 0; round < rounds; round++) {
+        // Dense start, then small batches; some edges change twice per batch
+        int changes = round == 0 ? 600 : 1 + rng() % 40;
+        for (int k = 0; k < changes; k++) {
+            int u = rng() % n;
+            int v = rng() % n;
+            if (u == v) continue;
+            paths.setWeight(u, v, uniform(rng) < 0.3 ? IncrementalApsp::NO_EDGE : 1 + 10 * uniform(rng));
+            if (uniform(rng) < 0.2)
+                paths.setWeight(u, v, 1 + 10 * uniform(rng));
+        }
+        paths.update();
+        mismatches += checkAgainstFloydWarshall(paths);
+    }
+    printf("random graphs:  %d rounds, %ld mismatches, %ld sources repaired, %ld full recomputations\n",
+           rounds, mismatches, paths.getNumSourcesRepaired(), paths.getNumFullRuns());
+    return mismatches;
+}
+
+static long movingNodes(int rounds, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    const int n = 50;
+    const double area = 1500;
+    const double range = 300;
+    std::vector<double> x(n), y(n), vx(n), vy(n);
+    for (int i = 0; i < n; i++) {
+        x[i] = area * uniform(rng);
+        y[i] = area * uniform(rng);
+        vx[i] = 4 * uniform(rng) - 2;    // m per round, ~0.1s steps at UAV speeds
+        vy[i] = 4 * uniform(rng) - 2;
+    }
+
+    IncrementalApsp paths;
+    paths.reset(n);
+    long mismatches = 0;
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < n; i++) {
+            x[i] += vx[i];
+            y[i] += vy[i];
+            if (x[i] < 0 || x[i] > area) vx[i] = -vx[i];
+            if (y[i] < 0 || y[i] > area) vy[i] = -vy[i];
+        }
+        // Cost grows with distance, like the per-hop fitness cost; small
+        // changes are skipped as with RouteOracle's weightTolerance
+        for (int u = 0; u < n; u++) {
+            for (int v = 0; v < n; v++) {
+                if (u == v) continue;
+                double d = std::hypot(x[u] - x[v], y[u] - y[v]);
+                double weight = d < range ? 1 + d / range : IncrementalApsp::NO_EDGE;
+                double current = paths.getWeight(u, v);
+                if (std::isinf(weight) != std::isinf(current) || std::fabs(weight - current) > 0.05 * current)
+                    paths.setWeight(u, v, weight);
+            }
+        }
+        paths.update();
+        mismatches += checkAgainstFloydWarshall(paths);
+    }
+    printf("moving nodes:   %d rounds, %ld mismatches, %ld sources repaired, %ld full recomputations\n",
+           rounds, mismatches, paths.getNumSourcesRepaired(), paths.getNumFullRuns());
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+    long mismatches = 0;
+    for (unsigned seed = 1; seed <= 3; seed++) {
+        mismatches += randomGraphs(rounds, seed);
+        mismatches += movingNodes(rounds, seed);
+    }
+    printf(mismatches ? "FAILED\n" : "PASSED\n");
+    return mismatches ? 1 : 0;
+}
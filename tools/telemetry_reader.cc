@@ -0,0 +1,168 @@
+//
+// telemetry_reader.cc
+// Live viewer for the SwarmTelemetry shared-memory segment
+//
+// Usage: telemetry_reader [-s /segment-name] [-i interval-ms] [-n max-rows] [--once]
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "TelemetryLayout.h"
+
+using namespace battelemetry;
+
+struct Snapshot {
+    SnapshotHeader header;
+    std::vector<NodeRecord> nodes;
+    uint64_t publishCount;
+};
+
+// Copy the active buffer out of the segment using the seqlock protocol.
+// Returns false if the writer kept overwriting it for too many attempts.
+static bool readSnapshot(void *segment, Snapshot &out)
+{
+    SegmentHeader *hdr = static_cast<SegmentHeader*>(segment);
+    out.nodes.resize(hdr->maxNodes);
+
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        int index = hdr->activeBuffer.load(std::memory_order_acquire);
+        uint64_t before = hdr->sequence[index].load(std::memory_order_acquire);
+        if (before == 0 || (before & 1)) {
+            // Nothing published yet, or the writer lapped us
+            std::this_thread::yield();
+            continue;
+        }
+
+        SnapshotHeader *snapshot = snapshotAt(segment, index);
+        out.header = *snapshot;
+        uint32_t count = std::min(out.header.numNodes, hdr->maxNodes);
+        memcpy(out.nodes.data(), nodesOf(snapshot), count * sizeof(NodeRecord));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = hdr->sequence[index].load(std::memory_order_relaxed);
+        if (before == after) {
+            out.nodes.resize(count);
+            out.publishCount = hdr->publishCount.load(std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void printSnapshot(const Snapshot &snap, size_t maxRows)
+{
+    uint64_t rreqs = 0, discovered = 0, routed = 0, entries = 0;
+    for (const NodeRecord &rec : snap.nodes) {
+        rreqs += rec.routeRequestsSent;
+        discovered += rec.routesDiscovered;
+        routed += rec.packetsRouted;
+        entries += rec.routeEntries;
+    }
+
+    printf("t=%.3fs  event=#%llu  nodes=%u  snapshot=%llu  rreqs=%llu  discovered=%llu  routed=%llu  routes=%llu\n",
+           snap.header.simTime, (unsigned long long)snap.header.eventNumber, snap.header.numNodes,
+           (unsigned long long)snap.publishCount, (unsigned long long)rreqs,
+           (unsigned long long)discovered, (unsigned long long)routed, (unsigned long long)entries);
+
+    if (maxRows == 0) return;
+    printf("  %5s %9s %9s %9s %8s %6s %7s %8s %8s\n",
+           "node", "x", "y", "z", "speed", "dests", "routes", "rreqs", "found");
+    for (size_t i = 0; i < snap.nodes.size() && i < maxRows; i++) {
+        const NodeRecord &rec = snap.nodes[i];
+        double speed = sqrt(rec.vx * rec.vx + rec.vy * rec.vy + rec.vz * rec.vz);
+        printf("  %5d %9.1f %9.1f %9.1f %8.2f %6d %7d %8llu %8llu\n",
+               rec.nodeId, rec.x, rec.y, rec.z, speed, rec.routeDestinations, rec.routeEntries,
+               (unsigned long long)rec.routeRequestsSent, (unsigned long long)rec.routesDiscovered);
+    }
+    if (snap.nodes.size() > maxRows)
+        printf("  ... %zu more nodes\n", snap.nodes.size() - maxRows);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-s /segment-name] [-i interval-ms] [-n max-rows] [--once]\n", prog);
+    fprintf(stderr, "  -s  Shared-memory segment name (default: /bat-telemetry)\n");
+    fprintf(stderr, "  -i  Polling interval in milliseconds (default: 500)\n");
+    fprintf(stderr, "  -n  Maximum per-node rows to print, 0 for summary only (default: 20)\n");
+    fprintf(stderr, "  --once  Print a single snapshot and exit\n");
+}
+
+int main(int argc, char **argv)
+{
+    std::string name = "/bat-telemetry";
+    int intervalMs = 500;
+    size_t maxRows = 20;
+    bool once = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-s" && i + 1 < argc)
+            name = argv[++i];
+        else if (arg == "-i" && i + 1 < argc)
+            intervalMs = atoi(argv[++i]);
+        else if (arg == "-n" && i + 1 < argc)
+            maxRows = atoi(argv[++i]);
+        else if (arg == "--once")
+            once = true;
+        else {
+            usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Error: cannot open segment %s: %s\n", name.c_str(), strerror(errno));
+        fprintf(stderr, "Is a simulation running with *.enableTelemetry = true?\n");
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SegmentHeader)) {
+        fprintf(stderr, "Error: segment %s is not initialized\n", name.c_str());
+        return 1;
+    }
+
+    // The reader only maps the segment read-only; all seqlock accesses are loads
+    void *segment = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        fprintf(stderr, "Error: mmap failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    SegmentHeader *hdr = static_cast<SegmentHeader*>(segment);
+    if (hdr->magic != TELEMETRY_MAGIC || hdr->version != TELEMETRY_VERSION
+        || (size_t)st.st_size < segmentSize(hdr->maxNodes)) {
+        fprintf(stderr, "Error: segment %s has an unknown layout\n", name.c_str());
+        return 1;
+    }
+
+    Snapshot snap;
+    uint64_t lastPublished = 0;
+    while (true) {
+        if (readSnapshot(segment, snap) && snap.publishCount != lastPublished) {
+            printSnapshot(snap, maxRows);
+            fflush(stdout);
+            lastPublished = snap.publishCount;
+            if (once) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+
+    munmap(segment, st.st_size);
+    return 0;
+}
@@ -0,0 +1,180 @@
+//
+// trace_convert.cc
+// Converts CSV mobility logs to the binary trace format replayed by
+// ArbitraryMobility (traceFile parameter)
+//
+// Usage: trace_convert input.csv output.trace
+//        trace_convert --info file.trace
+//
+// CSV columns: uavId,time,x,y,z (time in s, coordinates in m). Lines may be
+// in any order; a non-numeric first data line is treated as a header and lines
+// starting with '#' are ignored. UAV ids must be non-negative integers and
+// become track indices, so id N is replayed by uav[N] by default.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "TraceFormat.h"
+
+using namespace battrace;
+
+struct CsvRow {
+    uint32_t uavId;
+    TraceSample sample;
+};
+
+static bool parseRow(const char *line, CsvRow &row)
+{
+    long id;
+    double t, x, y, z;
+    if (sscanf(line, " %ld , %lf , %lf , %lf , %lf", &id, &t, &x, &y, &z) != 5 || id < 0)
+        return false;
+    row.uavId = id;
+    row.sample = TraceSample{t, x, y, z};
+    return true;
+}
+
+static int convert(const char *inputName, const char *outputName)
+{
+    FILE *in = fopen(inputName, "r");
+    if (!in) {
+        fprintf(stderr, "trace_convert: cannot open %s: %s\n", inputName, strerror(errno));
+        return 1;
+    }
+
+    std::vector<CsvRow> rows;
+    char line[1024];
+    long lineNo = 0;
+    bool firstDataLine = true;
+    while (fgets(line, sizeof(line), in)) {
+        lineNo++;
+        const char *p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+            continue;
+        CsvRow row;
+        bool header = firstDataLine;
+        firstDataLine = false;
+        if (!parseRow(p, row)) {
+            if (header)
+                continue;
+            fprintf(stderr, "trace_convert: %s:%ld: expected uavId,time,x,y,z\n", inputName, lineNo);
+            fclose(in);
+            return 1;
+        }
+        rows.push_back(row);
+    }
+    fclose(in);
+
+    if (rows.empty()) {
+        fprintf(stderr, "trace_convert: %s contains no waypoints\n", inputName);
+        return 1;
+    }
+
+    // Group by UAV, time order within each track (stable: equal timestamps
+    // keep their file order)
+    std::stable_sort(rows.begin(), rows.end(), [](const CsvRow &a, const CsvRow &b) {
+        return a.uavId != b.uavId ? a.uavId < b.uavId : a.sample.t < b.sample.t;
+    });
+
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.numTracks = rows.back().uavId + 1;
+    header.numSamples = rows.size();
+    header.startTime = rows[0].sample.t;
+    header.endTime = rows[0].sample.t;
+
+    std::vector<TraceTrack> tracks(header.numTracks, TraceTrack{0, 0, 0});
+    std::vector<TraceSample> samples;
+    samples.reserve(rows.size());
+    for (const CsvRow &row : rows) {
+        TraceTrack &track = tracks[row.uavId];
+        if (track.numSamples == 0)
+            track.firstSample = samples.size();
+        track.numSamples++;
+        samples.push_back(row.sample);
+        header.startTime = std::min(header.startTime, row.sample.t);
+        header.endTime = std::max(header.endTime, row.sample.t);
+    }
+
+    FILE *out = fopen(outputName, "wb");
+    if (!out) {
+        fprintf(stderr, "trace_convert: cannot create %s: %s\n", outputName, strerror(errno));
+        return 1;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+        && fwrite(tracks.data(), sizeof(TraceTrack), tracks.size(), out) == tracks.size()
+        && fwrite(samples.data(), sizeof(TraceSample), samples.size(), out) == samples.size();
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "trace_convert: error writing %s\n", outputName);
+        return 1;
+    }
+
+    int emptyTracks = std::count_if(tracks.begin(), tracks.end(), [](const TraceTrack &t) { return t.numSamples == 0; });
+    printf("%s: %u tracks (%d empty), %llu waypoints, t=[%g, %g]s\n", outputName, header.numTracks, emptyTracks,
+           (unsigned long long)header.numSamples, header.startTime, header.endTime);
+    return 0;
+}
+
+static int info(const char *fileName)
+{
+    int fd = open(fileName, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "trace_convert: cannot open %s: %s\n", fileName, strerror(errno));
+        return 1;
+    }
+    if ((size_t)st.st_size < sizeof(TraceHeader)) {
+        fprintf(stderr, "trace_convert: %s is not a trace file\n", fileName);
+        close(fd);
+        return 1;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "trace_convert: mmap failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    const TraceHeader *header = static_cast<const TraceHeader*>(data);
+    int result = 0;
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header->version != TRACE_VERSION) {
+        fprintf(stderr, "trace_convert: %s is not a version %u trace file\n", fileName, TRACE_VERSION);
+        result = 1;
+    }
+    else if ((uint64_t)st.st_size < traceFileSize(header->numTracks, header->numSamples)) {
+        fprintf(stderr, "trace_convert: %s is truncated\n", fileName);
+        result = 1;
+    }
+    else {
+        const TraceTrack *tracks = reinterpret_cast<const TraceTrack*>(static_cast<const char*>(data) + tracksOffset());
+        printf("%s: %u tracks, %llu waypoints, t=[%g, %g]s\n", fileName, header->numTracks,
+               (unsigned long long)header->numSamples, header->startTime, header->endTime);
+        for (uint32_t i = 0; i < header->numTracks; i++)
+            printf("  track %u: %u waypoints\n", i, tracks[i].numSamples);
+    }
+    munmap(data, st.st_size);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--info") == 0)
+        return info(argv[2]);
+    if (argc == 3 && argv[1][0] != '-')
+        return convert(argv[1], argv[2]);
+
+    fprintf(stderr, "Usage: %s input.csv output.trace\n"
+                    "       %s --info file.trace\n", argv[0], argv[0]);
+    return 2;
+}